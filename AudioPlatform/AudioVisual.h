@@ -12,6 +12,8 @@
 #include "imgui_impl_glfw.h"
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "AudioPlatform/Functions.h"
 
@@ -22,10 +24,42 @@ class AudioVisual {
   GLFWwindow *window = nullptr;
   RtAudio *dac = nullptr;
 
+  // one block rendered ahead, for when the device asks for frames that are
+  // not a whole number of blocks, and how many of its frames are not yet
+  // played
+  std::vector<float> fifo;
+  unsigned pending = 0;
+
+  // ask the audio device for sampleRate and blockSize (or AP_SAMPLE_RATE
+  // and AP_BLOCK_SIZE from the environment) and keep the rate it really
+  // does. blockSize must be a power of two, and is kept whatever the device
+  // does (see callback()). this happens before a subclass's members are
+  // made, so anything they work out from sampleRate or blockSize is right
+  // from the start. with AP_RENDER set, the device is left alone.
+  AudioVisual();
+
   virtual void setup() = 0;
   virtual void visual() = 0;
   virtual void audio(float *out) = 0;
+
+  // call setup(), start the audio and open a window, then run until the
+  // window closes. if AP_RENDER names a file, render() to that file instead
+  // (for AP_RENDER_SECONDS seconds, default 10).
   void start();
+
+  // fill frames from the device, which may be any number of them. audio()
+  // is always asked for exactly blockSize frames; what the device does not
+  // take yet is kept in fifo for its next call, which costs at most one
+  // block of latency when the sizes do not match.
+  void callback(float *out, unsigned frames);
+
+  // call setup() and then audio() as fast as possible, with no audio device
+  // or window, writing the output to a .wav file. visual() is never called,
+  // so anything an app sets from its GUI keeps its initial value.
+  void render(std::string filePath, float seconds);
+
+ private:
+  void open();
 };
 
 }  // namespace ap
@@ -0,0 +1,487 @@
+#ifndef __AP_BIQUAD_BANK__
+#define __AP_BIQUAD_BANK__
+
+#include "AudioPlatform/Globals.h"
+#include "AudioPlatform/Synths.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ap {
+
+// design n filters of one type at once, from arrays of frequencies (Hz) and
+// Qs into arrays of coefficients, 8 (AVX2) or 4 (SSE2) at a time. the same
+// as BiquadCoefficients::design for each, from the same table.
+inline void design(BiquadCoefficients::Type type, const float* f0,
+                   const float* Q, unsigned n, float* b0, float* b1,
+                   float* b2, float* a1, float* a2) {
+  const BiquadTable& table = BiquadTable::table();
+  unsigned i = 0;
+
+#if defined(__AVX2__)
+  const float scale = 2.0f * BiquadTable::size / sampleRate;
+  for (; i + 8 <= n; i += 8) {
+    // as in BiquadTable::lookup, with gathers
+    __m256 x = _mm256_mul_ps(_mm256_loadu_ps(&f0[i]), _mm256_set1_ps(scale));
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_setzero_ps()),
+                      _mm256_set1_ps(BiquadTable::size));
+    const __m256i j = _mm256_cvttps_epi32(x);
+    const __m256i j1 = _mm256_add_epi32(j, _mm256_set1_epi32(1));
+    const __m256 t = _mm256_sub_ps(x, _mm256_cvtepi32_ps(j));
+    const __m256 s0 = _mm256_i32gather_ps(table.sine, j, 4);
+    const __m256 s1 = _mm256_i32gather_ps(table.sine, j1, 4);
+    const __m256 c0 = _mm256_i32gather_ps(table.cosine, j, 4);
+    const __m256 c1 = _mm256_i32gather_ps(table.cosine, j1, 4);
+    const __m256 sh =
+        _mm256_add_ps(s0, _mm256_mul_ps(_mm256_sub_ps(s1, s0), t));
+    const __m256 ch =
+        _mm256_add_ps(c0, _mm256_mul_ps(_mm256_sub_ps(c1, c0), t));
+
+    // as in BiquadCoefficients::Terms
+    const __m256 sh2 = _mm256_mul_ps(sh, sh), ch2 = _mm256_mul_ps(ch, ch);
+    const __m256 one = _mm256_set1_ps(1), two = _mm256_set1_ps(2);
+    const __m256 s = _mm256_mul_ps(two, _mm256_mul_ps(sh, ch));
+    const __m256 c = _mm256_sub_ps(ch2, sh2);
+    const __m256 alpha =
+        _mm256_div_ps(s, _mm256_mul_ps(two, _mm256_loadu_ps(&Q[i])));
+    const __m256 r = _mm256_div_ps(one, _mm256_add_ps(one, alpha));
+
+    // as in BiquadCoefficients::lpf and the others, before normalizing
+    __m256 n0, n1, n2;
+    switch (type) {
+      case BiquadCoefficients::LPF:
+        n0 = n2 = sh2;
+        n1 = _mm256_mul_ps(two, sh2);
+        break;
+      case BiquadCoefficients::HPF:
+        n0 = n2 = ch2;
+        n1 = _mm256_mul_ps(_mm256_set1_ps(-2), ch2);
+        break;
+      case BiquadCoefficients::BPF:
+        n0 = _mm256_mul_ps(_mm256_set1_ps(0.5f), s);
+        n1 = _mm256_setzero_ps();
+        n2 = _mm256_mul_ps(_mm256_set1_ps(-0.5f), s);
+        break;
+      case BiquadCoefficients::NOTCH:
+        n0 = n2 = one;
+        n1 = _mm256_mul_ps(_mm256_set1_ps(-2), c);
+        break;
+      default:
+        n0 = _mm256_sub_ps(one, alpha);
+        n1 = _mm256_mul_ps(_mm256_set1_ps(-2), c);
+        n2 = _mm256_add_ps(one, alpha);
+        break;
+    }
+    _mm256_storeu_ps(&b0[i], _mm256_mul_ps(n0, r));
+    _mm256_storeu_ps(&b1[i], _mm256_mul_ps(n1, r));
+    _mm256_storeu_ps(&b2[i], _mm256_mul_ps(n2, r));
+    _mm256_storeu_ps(&a1[i],
+                     _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(-2), c), r));
+    _mm256_storeu_ps(&a2[i], _mm256_mul_ps(_mm256_sub_ps(one, alpha), r));
+  }
+#elif defined(__SSE2__)
+  for (; i + 4 <= n; i += 4) {
+    // SSE2 has no gather, so the lookups are one at a time
+    float shs[4], chs[4];
+    for (unsigned k = 0; k < 4; ++k) table.lookup(f0[i + k], shs[k], chs[k]);
+    const __m128 sh = _mm_loadu_ps(shs), ch = _mm_loadu_ps(chs);
+
+    // as in BiquadCoefficients::Terms
+    const __m128 sh2 = _mm_mul_ps(sh, sh), ch2 = _mm_mul_ps(ch, ch);
+    const __m128 one = _mm_set1_ps(1), two = _mm_set1_ps(2);
+    const __m128 s = _mm_mul_ps(two, _mm_mul_ps(sh, ch));
+    const __m128 c = _mm_sub_ps(ch2, sh2);
+    const __m128 alpha = _mm_div_ps(s, _mm_mul_ps(two, _mm_loadu_ps(&Q[i])));
+    const __m128 r = _mm_div_ps(one, _mm_add_ps(one, alpha));
+
+    // as in BiquadCoefficients::lpf and the others, before normalizing
+    __m128 n0, n1, n2;
+    switch (type) {
+      case BiquadCoefficients::LPF:
+        n0 = n2 = sh2;
+        n1 = _mm_mul_ps(two, sh2);
+        break;
+      case BiquadCoefficients::HPF:
+        n0 = n2 = ch2;
+        n1 = _mm_mul_ps(_mm_set1_ps(-2), ch2);
+        break;
+      case BiquadCoefficients::BPF:
+        n0 = _mm_mul_ps(_mm_set1_ps(0.5f), s);
+        n1 = _mm_setzero_ps();
+        n2 = _mm_mul_ps(_mm_set1_ps(-0.5f), s);
+        break;
+      case BiquadCoefficients::NOTCH:
+        n0 = n2 = one;
+        n1 = _mm_mul_ps(_mm_set1_ps(-2), c);
+        break;
+      default:
+        n0 = _mm_sub_ps(one, alpha);
+        n1 = _mm_mul_ps(_mm_set1_ps(-2), c);
+        n2 = _mm_add_ps(one, alpha);
+        break;
+    }
+    _mm_storeu_ps(&b0[i], _mm_mul_ps(n0, r));
+    _mm_storeu_ps(&b1[i], _mm_mul_ps(n1, r));
+    _mm_storeu_ps(&b2[i], _mm_mul_ps(n2, r));
+    _mm_storeu_ps(&a1[i], _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(-2), c), r));
+    _mm_storeu_ps(&a2[i], _mm_mul_ps(_mm_sub_ps(one, alpha), r));
+  }
+#endif
+
+  for (; i < n; ++i) {
+    BiquadCoefficients c;
+    c.design(type, f0[i], Q[i]);
+    b0[i] = c.b0;
+    b1[i] = c.b1;
+    b2[i] = c.b2;
+    a1[i] = c.a1;
+    a2[i] = c.a2;
+  }
+}
+
+// biquads in series, in transposed direct form II. this does what nesting
+// calls does (filter[0](filter[1](...))), with the sections' coefficients
+// and state stored as arrays (structure-of-arrays), one entry per section.
+//
+// each section depends on the one before, and each sample on the one before,
+// so the sections are run as a wavefront: 8 (AVX2) or 4 (SSE2) sections, one
+// in each lane, where lane k works on the sample that lane k - 1 finished on
+// the step before. a block of n samples takes n + 7 (or n + 3) steps for
+// each group of 8 (or 4) sections, and there is no added latency.
+//
+struct BiquadCascade {
+#if defined(__AVX2__)
+  static const unsigned lanes = 8;
+#elif defined(__SSE2__)
+  static const unsigned lanes = 4;
+#else
+  static const unsigned lanes = 1;
+#endif
+
+  // per-section state; padded with sections that pass their input through
+  std::vector<float> b0, b1, b2, a1, a2;
+  std::vector<float> z1, z2;
+  unsigned count = 0;
+
+  void setup(unsigned sections) {
+    count = sections;
+    unsigned padded = (sections + lanes - 1) / lanes * lanes;
+    for (auto* v : {&b0, &b1, &b2, &a1, &a2, &z1, &z2})
+      v->assign(padded, 0.0f);
+    for (unsigned k = 0; k < padded; ++k) b0[k] = 1;
+  }
+
+  unsigned size() const { return count; }
+
+  void set(unsigned k, const BiquadCoefficients& c) {
+    b0[k] = c.b0;
+    b1[k] = c.b1;
+    b2[k] = c.b2;
+    a1[k] = c.a1;
+    a2[k] = c.a2;
+  }
+
+  // design the first n sections, with a frequency and Q for each
+  void design(BiquadCoefficients::Type type, const float* f0, const float* Q,
+              unsigned n) {
+    ap::design(type, f0, Q, n, &b0[0], &b1[0], &b2[0], &a1[0], &a2[0]);
+  }
+
+  void clear() {
+    for (unsigned k = 0; k < z1.size(); ++k) z1[k] = z2[k] = 0;
+  }
+
+  // filter a block through every section; in and out may be the same
+  void process(const float* in, float* out, unsigned n) {
+    for (unsigned k = 0; k < b0.size(); k += lanes) {
+      group(k, in, out, n);
+      in = out;
+    }
+  }
+
+#if defined(__AVX2__)
+  void group(unsigned k, const float* in, float* out, unsigned n) {
+    const __m256 B0 = _mm256_loadu_ps(&b0[k]), B1 = _mm256_loadu_ps(&b1[k]);
+    const __m256 B2 = _mm256_loadu_ps(&b2[k]), A1 = _mm256_loadu_ps(&a1[k]);
+    const __m256 A2 = _mm256_loadu_ps(&a2[k]);
+    __m256 s1 = _mm256_loadu_ps(&z1[k]), s2 = _mm256_loadu_ps(&z2[k]);
+    const __m256i shift = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    const __m256 lane = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 y = _mm256_setzero_ps();
+    for (unsigned t = 0; t < n + 7; ++t) {
+      // lane 0 takes the next input; the others take what the lane below
+      // put out on the step before
+      const float input = t < n ? in[t] : 0.0f;
+      const __m256 x = _mm256_blend_ps(_mm256_permutevar8x32_ps(y, shift),
+                                       _mm256_set1_ps(input), 1);
+
+      // as in Biquad::operator()
+      y = _mm256_add_ps(_mm256_mul_ps(B0, x), s1);
+      __m256 n1 = _mm256_add_ps(
+          _mm256_sub_ps(_mm256_mul_ps(B1, x), _mm256_mul_ps(A1, y)), s2);
+      __m256 n2 = _mm256_sub_ps(_mm256_mul_ps(B2, x), _mm256_mul_ps(A2, y));
+
+      // only while filling or draining are some lanes not working on a
+      // sample of this block; they keep their state
+      if (t < 7 || t >= n) {
+        const __m256 active = _mm256_and_ps(
+            _mm256_cmp_ps(lane, _mm256_set1_ps(t), _CMP_LE_OQ),
+            _mm256_cmp_ps(lane, _mm256_set1_ps(float(t) - n), _CMP_GT_OQ));
+        n1 = _mm256_blendv_ps(s1, n1, active);
+        n2 = _mm256_blendv_ps(s2, n2, active);
+      }
+      s1 = n1;
+      s2 = n2;
+
+      // the top lane finished sample t - 7
+      if (t >= 7)
+        out[t - 7] = _mm_cvtss_f32(_mm_shuffle_ps(
+            _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(y, 1), 3));
+    }
+    _mm256_storeu_ps(&z1[k], s1);
+    _mm256_storeu_ps(&z2[k], s2);
+  }
+#elif defined(__SSE2__)
+  void group(unsigned k, const float* in, float* out, unsigned n) {
+    const __m128 B0 = _mm_loadu_ps(&b0[k]), B1 = _mm_loadu_ps(&b1[k]);
+    const __m128 B2 = _mm_loadu_ps(&b2[k]), A1 = _mm_loadu_ps(&a1[k]);
+    const __m128 A2 = _mm_loadu_ps(&a2[k]);
+    __m128 s1 = _mm_loadu_ps(&z1[k]), s2 = _mm_loadu_ps(&z2[k]);
+    const __m128 lane = _mm_setr_ps(0, 1, 2, 3);
+    __m128 y = _mm_setzero_ps();
+    for (unsigned t = 0; t < n + 3; ++t) {
+      // lane 0 takes the next input; the others take what the lane below
+      // put out on the step before
+      const float input = t < n ? in[t] : 0.0f;
+      const __m128 x = _mm_move_ss(
+          _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(y), 4)),
+          _mm_set_ss(input));
+
+      // as in Biquad::operator()
+      y = _mm_add_ps(_mm_mul_ps(B0, x), s1);
+      __m128 n1 =
+          _mm_add_ps(_mm_sub_ps(_mm_mul_ps(B1, x), _mm_mul_ps(A1, y)), s2);
+      __m128 n2 = _mm_sub_ps(_mm_mul_ps(B2, x), _mm_mul_ps(A2, y));
+
+      // only while filling or draining are some lanes not working on a
+      // sample of this block; they keep their state
+      if (t < 3 || t >= n) {
+        const __m128 active =
+            _mm_and_ps(_mm_cmple_ps(lane, _mm_set1_ps(t)),
+                       _mm_cmpgt_ps(lane, _mm_set1_ps(float(t) - n)));
+        n1 = _mm_or_ps(_mm_and_ps(active, n1), _mm_andnot_ps(active, s1));
+        n2 = _mm_or_ps(_mm_and_ps(active, n2), _mm_andnot_ps(active, s2));
+      }
+      s1 = n1;
+      s2 = n2;
+
+      // the top lane finished sample t - 3
+      if (t >= 3) out[t - 3] = _mm_cvtss_f32(_mm_shuffle_ps(y, y, 3));
+    }
+    _mm_storeu_ps(&z1[k], s1);
+    _mm_storeu_ps(&z2[k], s2);
+  }
+#else
+  void group(unsigned k, const float* in, float* out, unsigned n) {
+    const float B0 = b0[k], B1 = b1[k], B2 = b2[k], A1 = a1[k], A2 = a2[k];
+    float s1 = z1[k], s2 = z2[k];
+    for (unsigned i = 0; i < n; ++i) {
+      const float x0 = in[i];
+      const float y0 = B0 * x0 + s1;
+      s1 = B1 * x0 - A1 * y0 + s2;
+      s2 = B2 * x0 - A2 * y0;
+      out[i] = y0;
+    }
+    z1[k] = s1;
+    z2[k] = s2;
+  }
+#endif
+};
+
+// independent biquads in parallel, all fed the same input, their outputs
+// summed with a gain for each. this does what a set of Biquads (or
+// BiquadWithLines) with their outputs added does, like the three formant
+// filters of example/formant-synth.cpp, but 8 (AVX2) or 4 (SSE2) filters
+// are run at once, one in each lane, in transposed direct form II.
+//
+// coefficient and gain changes ramp linearly over the next process() call.
+// the filters stay stable while they do: a straight line between two stable
+// filters never leaves the (a1, a2) stability triangle.
+//
+struct BiquadBank {
+  // per-filter state; padded with silent filters to a multiple of lanes
+  std::vector<float> b0, b1, b2, a1, a2, gain;
+  std::vector<float> z1, z2;
+  std::vector<float> target, step;  // 6 per filter: b0 b1 b2 a1 a2 gain
+  std::vector<float> dry;           // the input, when out is written over it
+  unsigned count = 0;
+
+  // allocate for blocks of up to n samples
+  void setup(unsigned filters, unsigned n = blockSize) {
+    count = filters;
+    unsigned padded = (filters + lanes - 1) / lanes * lanes;
+    for (auto* v : {&b0, &b1, &b2, &a1, &a2, &gain, &z1, &z2})
+      v->assign(padded, 0.0f);
+    target.assign(6 * padded, 0.0f);
+    step.assign(6 * padded, 0.0f);
+    dry.assign(n, 0.0f);
+
+    // a gain of 1, for filters that are only ever designed
+    for (unsigned k = 0; k < padded; ++k) gain[k] = target[5 * padded + k] = 1;
+  }
+
+  // set the target coefficients and gain of filter k
+  void set(unsigned k, const BiquadCoefficients& c, float g = 1.0f) {
+    const unsigned padded = b0.size();
+    target[0 * padded + k] = c.b0;
+    target[1 * padded + k] = c.b1;
+    target[2 * padded + k] = c.b2;
+    target[3 * padded + k] = c.a1;
+    target[4 * padded + k] = c.a2;
+    target[5 * padded + k] = g;
+  }
+
+  // set the target coefficients of every filter, with a frequency and Q for
+  // each; their gains are left as they are
+  void design(BiquadCoefficients::Type type, const float* f0, const float* Q) {
+    const unsigned padded = b0.size();
+    ap::design(type, f0, Q, count, &target[0 * padded], &target[1 * padded],
+               &target[2 * padded], &target[3 * padded], &target[4 * padded]);
+  }
+
+  // jump to the targets, rather than ramping to them
+  void jump() {
+    const unsigned padded = b0.size();
+    float* v[6] = {&b0[0], &b1[0], &b2[0], &a1[0], &a2[0], &gain[0]};
+    for (unsigned j = 0; j < 6; ++j)
+      for (unsigned k = 0; k < padded; ++k) v[j][k] = target[j * padded + k];
+  }
+
+  void clear() {
+    for (unsigned k = 0; k < z1.size(); ++k) z1[k] = z2[k] = 0;
+  }
+
+  // write the sum of the filtered input into out; in and out may be the same
+  void process(const float* in, float* out, unsigned n) {
+    const unsigned padded = b0.size();
+    float* v[6] = {&b0[0], &b1[0], &b2[0], &a1[0], &a2[0], &gain[0]};
+    const float scale = 1.0f / n;
+    for (unsigned j = 0; j < 6; ++j)
+      for (unsigned k = 0; k < padded; ++k)
+        step[j * padded + k] = (target[j * padded + k] - v[j][k]) * scale;
+
+    // each group of filters runs over the whole block with its coefficients
+    // and state in registers, adding into out. later groups still need the
+    // input after the first has written over it.
+    if (in == out && padded > lanes) {
+      assert(n <= dry.size());
+      std::copy(in, in + n, dry.begin());
+      in = &dry[0];
+    }
+    for (unsigned k = 0; k < padded; k += lanes) group(k, in, out, n, k == 0);
+
+    // land exactly on the targets
+    jump();
+  }
+
+#if defined(__AVX2__)
+  static const unsigned lanes = 8;
+  void group(unsigned k, const float* in, float* out, unsigned n, bool first) {
+    const unsigned padded = b0.size();
+    float* p[6] = {&b0[k], &b1[k], &b2[k], &a1[k], &a2[k], &gain[k]};
+    __m256 c[6], d[6];
+    for (unsigned j = 0; j < 6; ++j) {
+      c[j] = _mm256_loadu_ps(p[j]);
+      d[j] = _mm256_loadu_ps(&step[j * padded + k]);
+    }
+    __m256 s1 = _mm256_loadu_ps(&z1[k]), s2 = _mm256_loadu_ps(&z2[k]);
+    for (unsigned i = 0; i < n; ++i) {
+      const __m256 x = _mm256_set1_ps(in[i]);
+
+      // as in Biquad::operator()
+      const __m256 y = _mm256_add_ps(_mm256_mul_ps(c[0], x), s1);
+      s1 = _mm256_add_ps(
+          _mm256_sub_ps(_mm256_mul_ps(c[1], x), _mm256_mul_ps(c[3], y)), s2);
+      s2 = _mm256_sub_ps(_mm256_mul_ps(c[2], x), _mm256_mul_ps(c[4], y));
+
+      const __m256 g = _mm256_mul_ps(y, c[5]);
+      __m128 sum = _mm_add_ps(_mm256_castps256_ps128(g),
+                              _mm256_extractf128_ps(g, 1));
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+      sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+      out[i] = first ? _mm_cvtss_f32(sum) : out[i] + _mm_cvtss_f32(sum);
+
+      // ramp
+      for (unsigned j = 0; j < 6; ++j) c[j] = _mm256_add_ps(c[j], d[j]);
+    }
+    _mm256_storeu_ps(&z1[k], s1);
+    _mm256_storeu_ps(&z2[k], s2);
+  }
+#elif defined(__SSE2__)
+  static const unsigned lanes = 4;
+  void group(unsigned k, const float* in, float* out, unsigned n, bool first) {
+    const unsigned padded = b0.size();
+    float* p[6] = {&b0[k], &b1[k], &b2[k], &a1[k], &a2[k], &gain[k]};
+    __m128 c[6], d[6];
+    for (unsigned j = 0; j < 6; ++j) {
+      c[j] = _mm_loadu_ps(p[j]);
+      d[j] = _mm_loadu_ps(&step[j * padded + k]);
+    }
+    __m128 s1 = _mm_loadu_ps(&z1[k]), s2 = _mm_loadu_ps(&z2[k]);
+    for (unsigned i = 0; i < n; ++i) {
+      const __m128 x = _mm_set1_ps(in[i]);
+
+      // as in Biquad::operator()
+      const __m128 y = _mm_add_ps(_mm_mul_ps(c[0], x), s1);
+      s1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c[1], x), _mm_mul_ps(c[3], y)),
+                      s2);
+      s2 = _mm_sub_ps(_mm_mul_ps(c[2], x), _mm_mul_ps(c[4], y));
+
+      __m128 sum = _mm_mul_ps(y, c[5]);
+      sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+      sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+      out[i] = first ? _mm_cvtss_f32(sum) : out[i] + _mm_cvtss_f32(sum);
+
+      // ramp
+      for (unsigned j = 0; j < 6; ++j) c[j] = _mm_add_ps(c[j], d[j]);
+    }
+    _mm_storeu_ps(&z1[k], s1);
+    _mm_storeu_ps(&z2[k], s2);
+  }
+#else
+  static const unsigned lanes = 1;
+  void group(unsigned k, const float* in, float* out, unsigned n, bool first) {
+    const unsigned padded = b0.size();
+    float* v[6] = {&b0[k], &b1[k], &b2[k], &a1[k], &a2[k], &gain[k]};
+    float c[6], d[6];
+    for (unsigned j = 0; j < 6; ++j) {
+      c[j] = *v[j];
+      d[j] = step[j * padded + k];
+    }
+    float s1 = z1[k], s2 = z2[k];
+    for (unsigned i = 0; i < n; ++i) {
+      const float x = in[i];
+      const float y = c[0] * x + s1;
+      s1 = c[1] * x - c[3] * y + s2;
+      s2 = c[2] * x - c[4] * y;
+      out[i] = first ? y * c[5] : out[i] + y * c[5];
+
+      // ramp
+      for (unsigned j = 0; j < 6; ++j) c[j] += d[j];
+    }
+    z1[k] = s1;
+    z2[k] = s2;
+  }
+#endif
+};
+
+}  // namespace ap
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __AP_CONVOLVER__
+#define __AP_CONVOLVER__
+
+#include <vector>
+#include "AudioFFT/AudioFFT.h"
+
+namespace ap {
+
+// uniformly partitioned overlap-save convolution
+//
+// the impulse response is cut into partitions of blockSize samples and each
+// one is transformed once, in setup(). each call to process() transforms one
+// new block of input, multiplies the spectra of the most recent blocks with
+// the spectra of the partitions, and transforms back. the cost per block is
+// one FFT/IFFT pair plus a complex multiply-add per partition, rather than
+// blockSize * irSize multiply-adds.
+//
+// real-time use, inside AudioVisual::audio:
+//
+//   convolver.setup(ir.data, ir.size, blockSize);  // in setup()
+//   convolver.process(dry, wet);                   // once per block
+//
+// the output of process() is the input block convolved with the impulse
+// response, so the latency is just the one block of audio I/O.
+//
+struct Convolver {
+  audiofft::AudioFFT fft;
+  unsigned blockSize = 0, complexSize = 0, partitions = 0, current = 0;
+
+  // the last two blocks of input and the result of the last IFFT
+  std::vector<float> input, output;
+
+  // the spectrum of each partition of the impulse response
+  std::vector<float> filterReal, filterImag;
+
+  // the spectrum of each of the most recent blocks of input (a frequency
+  // domain delay line); current is the newest one
+  std::vector<float> historyReal, historyImag;
+
+  // accumulated products
+  std::vector<float> sumReal, sumImag;
+
+  void setup(const float* ir, unsigned irSize, unsigned blockSize);
+  void reset();
+
+  // convolve exactly blockSize samples of input
+  void process(const float* in, float* out);
+
+  // convolve two whole signals offline; fg gets f.size + g.size - 1 samples
+  static void convolve(const float* f, unsigned fSize, const float* g,
+                       unsigned gSize, std::vector<float>& fg);
+};
+
+}  // namespace ap
+
+#endif
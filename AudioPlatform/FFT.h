@@ -7,26 +7,122 @@
 
 namespace ap {
 
+// callback that works on a spectrum in place, as (real, imag) arrays of n
+// bins (DC to Nyquist)
+typedef std::function<void(float* real, float* imag, unsigned n)>
+    ComplexProcess;
+
 struct FFT : audiofft::AudioFFT {
   void setup(unsigned size);
   void forward(const float* data);
   void reverse(float* data);
 
+  // the spectrum is kept as (real, imag), which is what the FFT computes, and
+  // converted to (magnitude, phase) only when one of those is read. writing
+  // magnitude or phase (assigning to an element, or through write()) makes
+  // them the authoritative representation, and reverse() converts back
+  // first. reading them does not, so a spectrum that is only looked at
+  // goes back through reverse() untouched.
+  //
+  // to read or write real/imag directly after magnitude or phase may have
+  // been changed, call rectangular() first.
+  void rectangular();
+  void polar();
+
+  // how the conversions are done. FAST uses the approximations in
+  // FastMath.h; EXACT uses libm.
+  enum Conversion { EXACT, FAST };
+  Conversion conversion = FAST;
+
+  // magnitude or phase; behaves like a std::vector<float> of fixed size.
+  // reads are through data(), begin() and end(), which are const; writes
+  // are through write(), or an element, which only counts as written when
+  // it is assigned to.
+  struct Polar {
+    FFT* fft = nullptr;
+    std::vector<float> value;
+
+    struct Element {
+      Polar& polar;
+      unsigned i;
+      operator float() const { return polar.data()[i]; }
+      Element& operator=(float f) {
+        polar.write()[i] = f;
+        return *this;
+      }
+      Element& operator=(const Element& e) { return *this = float(e); }
+      Element& operator+=(float f) { return *this = float(*this) + f; }
+      Element& operator-=(float f) { return *this = float(*this) - f; }
+      Element& operator*=(float f) { return *this = float(*this) * f; }
+      Element& operator/=(float f) { return *this = float(*this) / f; }
+    };
+
+    unsigned size() const { return value.size(); }
+    float operator[](unsigned i) const { return data()[i]; }
+    Element operator[](unsigned i) { return Element{*this, i}; }
+    const float* data() const {
+      if (!fft->polarValid) fft->polar();
+      return &value[0];
+    }
+    float* write() {
+      if (!fft->polarValid) fft->polar();
+      fft->rectangularValid = false;
+      return &value[0];
+    }
+    const float* begin() const { return data(); }
+    const float* end() const { return data() + size(); }
+  };
+
   unsigned size = 0;
-  std::vector<float> magnitude, phase;
+  std::vector<float> real, imag;
+  Polar magnitude, phase;
+  bool rectangularValid = true, polarValid = true;
+
+  FFT() = default;
+  FFT(const FFT&) = delete;
+  FFT& operator=(const FFT&) = delete;
 };
 
+// short-time fourier transform with overlap-add resynthesis. each hop, the
+// last windowSize samples of input are multiplied by the analysis window and
+// transformed; after processing, the inverse is multiplied by the synthesis
+// window and added to the output. the synthesis window is scaled so that the
+// windows overlap-add to exactly 1, so any pair of windows works at any
+// overlap. output lags input by windowSize samples.
+//
 struct STFT : FFT {
-  struct Buf : std::vector<float> {
-    unsigned n;
-  } in[2], out[2];
-  std::vector<float> window;
-  unsigned windowSize, hop;
+  unsigned windowSize = 0, hop = 0, overlap = 0;
+  std::vector<float> analysis, synthesis;
+  std::vector<float> input, output, frame;
+  unsigned fill = 0;
+
+  // overlap is the number of frames over each sample: 2, 4, 8... it must
+  // divide windowSize. the default windows are both sqrt(hann).
+  void setup(unsigned windowSize, unsigned overlap = 2);
+  void setup(unsigned windowSize, unsigned overlap,
+             const std::vector<float>& analysis,
+             const std::vector<float>& synthesis);
+
+  // process a block of n samples, calling process for each frame. in and out
+  // may be the same.
+  void process(const float* in, float* out, unsigned n,
+               const std::function<void(void)>& process);
+  void process(const float* in, float* out, unsigned n,
+               const ComplexProcess& process);
 
-  void setup(unsigned _windowSize);
+  // sample at a time: give the input with operator()(float), which returns
+  // true when a frame has been analyzed and may be processed, then take the
+  // output with operator()().
   bool operator()(float f);
   float operator()();
   float operator()(float f, std::function<void(void)> process);
+
+  // as above, but the callback gets the spectrum as (real, imag), so no
+  // polar conversion is done unless it asks for magnitude or phase
+  float operator()(float f, ComplexProcess process);
+
+  void analyze();
+  void synthesize();
 };
 
 }  // namespace ap
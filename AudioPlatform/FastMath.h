@@ -0,0 +1,198 @@
+#ifndef __AP_FAST_MATH__
+#define __AP_FAST_MATH__
+
+#include <cmath>
+#include <cstdint>
+
+namespace ap {
+
+// polynomial approximations of functions that get called once per sample or
+// once per bin per frame. the array kernels (toPolar, toRectangular,
+// fastExp2, fastLog2) do the same arithmetic as the scalar functions 4 at a
+// time on SSE2 (with a scalar loop on other machines), so the two agree
+// exactly, or to a few ulp where the compiler fuses multiply-adds in the
+// scalar code (as -mfma lets it).
+//
+// some take a Precision: FINE is as close as float gets, COARSE is cheaper
+// and good enough for control signals and drawing.
+//
+// error bounds, measured against double precision libm by
+// tool/fastmath-error.cpp:
+//
+//   fastAtan2        |error| < 1.2e-5 radians (A&S 4.4.47)
+//   fastSinCos       |error| < 1e-7 for |x| < 100, < 5e-7 for |x| < 2^15
+//                    (Cephes sinf/cosf polynomials)
+//   fastSin          FINE as fastSinCos; COARSE |error| < 1.2e-5
+//   toPolar          magnitude is sqrt, phase as fastAtan2
+//   toRectangular    as fastSinCos, times the magnitude
+//   fastLog2         FINE |error| < 2e-7 in [0.5, 2), and a few ulp of the
+//                    result elsewhere; COARSE |error| < 6e-6. exact at 0,
+//                    inf, NaN and negatives
+//   fastExp2         FINE relative error < 2.5e-7; COARSE < 7.5e-5 for x
+//                    in [-126, 127]; 0 below -126.5, 2^127 up to 128,
+//                    then inf
+//   fastTanh         FINE |error| < 2.5e-7; COARSE < 4e-5
+//
+// fastSinCos reduces its argument with a 3-part pi/2 (Cody-Waite); beyond
+// 2^15 radians the reduction loses bits and the error grows.
+
+enum Precision { COARSE, FINE };
+
+// minimax polynomials, lowest power first, for COARSE and FINE: 2^f for f in
+// [-0.5, 0.5], and atanh(s) / s in s^2 for the mantissa of fastLog2
+static const unsigned exp2Degree[2] = {3, 5};
+static const float exp2Polynomial[2][6] = {
+    {9.999280740e-01f, 6.932609938e-01f, 2.426111187e-01f, 5.517162372e-02f},
+    {1.000000072e+00f, 6.931469671e-01f, 2.402211972e-01f, 5.550713290e-02f,
+     9.675541296e-03f, 1.327646652e-03f},
+};
+static const unsigned log2Degree[2] = {1, 3};
+static const float log2Polynomial[2][4] = {
+    {9.999440258e-01f, 3.408670185e-01f},
+    {1.0f, 0.333333333f, 0.2f, 0.142857143f},
+};
+
+// the quadrant comes from the sign bits, so -0 is on the negative side, as
+// it is for atan2
+inline float fastAtan2(float y, float x) {
+  union {
+    float f;
+    uint32_t i;
+  } ux, uy;
+  ux.f = x;
+  uy.f = y;
+  const float ax = x < 0 ? -x : x;
+  const float ay = y < 0 ? -y : y;
+  const float mx = ax > ay ? ax : ay;
+  const float mn = ax > ay ? ay : ax;
+  const float a = mx > 0 ? mn / mx : 0;
+  const float s = a * a;
+  float r = a * (0.9998660f +
+                 s * (-0.3302995f +
+                      s * (0.1801410f + s * (-0.0851330f + s * 0.0208351f))));
+  if (ay > ax) r = 1.57079637f - r;
+  if (ux.i >> 31) r = 3.14159274f - r;
+  if (uy.i >> 31) r = -r;
+  return r;
+}
+
+inline void fastSinCos(float x, float& sin, float& cos) {
+  const float f = x * 0.636619772f;  // 2/pi
+  const int32_t q = int32_t(f < 0 ? f - 0.5f : f + 0.5f);
+  const float qf = float(q);
+  const float r =
+      ((x - qf * 1.5703125f) - qf * 4.837512969970703125e-4f) -
+      qf * 7.54978995489188216e-8f;
+  const float z = r * r;
+  const float s =
+      r + r * z * (-1.6666654611e-1f +
+                   z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+  const float c =
+      1.0f - 0.5f * z +
+      z * z * (4.166664568298827e-2f +
+               z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+  sin = (q & 1) ? c : s;
+  cos = (q & 1) ? s : c;
+  if (q & 2) sin = -sin;
+  if ((q + 1) & 2) cos = -cos;
+}
+
+// the same, with fewer terms for COARSE
+inline float fastSin(float x, Precision precision = FINE) {
+  if (precision == FINE) {
+    float s, c;
+    fastSinCos(x, s, c);
+    return s;
+  }
+  const float f = x * 0.636619772f;  // 2/pi
+  const int32_t q = int32_t(f < 0 ? f - 0.5f : f + 0.5f);
+  const float qf = float(q);
+  const float r =
+      ((x - qf * 1.5703125f) - qf * 4.837512969970703125e-4f) -
+      qf * 7.54978995489188216e-8f;
+  const float z = r * r;
+  float s = r * (9.999949978e-01f +
+                 z * (-1.666016211e-01f + z * 8.121559436e-03f));
+  if (q & 1)
+    s = 9.999900712e-01f + z * (-4.997083769e-01f + z * 4.039884359e-02f);
+  return (q & 2) ? -s : s;
+}
+
+// the exponent from the bits, and the log of the mantissa (taken to
+// [sqrt(1/2), sqrt(2))) from the series for atanh. denormals are scaled up
+// by 2^23 first; 0 gives -inf, +inf gives +inf, and negatives and NaN give
+// NaN, as for log2.
+inline float fastLog2(float x, Precision precision = FINE) {
+  if (!(x > 0)) return x == 0 ? -HUGE_VALF : NAN;
+  if (x == HUGE_VALF) return x;
+  int bias = 127;
+  if (x < 1.17549435e-38f) {  // FLT_MIN
+    x *= 8388608.0f;          // 2^23
+    bias += 23;
+  }
+  union {
+    float f;
+    uint32_t i;
+  } u;
+  u.f = x;
+  int e = int((u.i >> 23) & 255) - bias;
+  u.i = (u.i & 0x007FFFFF) | 0x3F800000;  // mantissa, in [1, 2)
+  if (u.f > 1.41421356f) {
+    u.f *= 0.5f;
+    e += 1;
+  }
+  const float s = (u.f - 1.0f) / (u.f + 1.0f);
+  const float z = s * s;
+  const float* c = log2Polynomial[precision];
+  float p = c[log2Degree[precision]];
+  for (int k = log2Degree[precision] - 1; k >= 0; --k) p = p * z + c[k];
+  const float ln = 2.0f * s * p;
+  return e + ln * 1.44269504f;  // 1/ln(2)
+}
+
+// 2 to the nearest integer (made in the exponent bits) times a polynomial
+// for 2 to the rest. below -126.5 the nearest integer is -127, whose
+// exponent bits are 0, so the result is 0 rather than a denormal. from 128
+// up it is inf, and NaN gives NaN.
+inline float fastExp2(float x, Precision precision = FINE) {
+  if (!(x < 128.0f)) return x + HUGE_VALF;  // inf, or NaN
+  x = x < -127.0f ? -127.0f : (x > 127.0f ? 127.0f : x);
+  const int32_t i = int32_t(x < 0 ? x - 0.5f : x + 0.5f);
+  const float f = x - float(i);
+  const float* c = exp2Polynomial[precision];
+  float p = c[exp2Degree[precision]];
+  for (int k = exp2Degree[precision] - 1; k >= 0; --k) p = p * f + c[k];
+  union {
+    float f;
+    uint32_t i;
+  } u;
+  u.i = uint32_t(i + 127) << 23;
+  return p * u.f;
+}
+
+// 1 - 2 / (e^2x + 1). beyond 9, tanh rounds to 1; stopping there also keeps
+// 2 / (e^2x + 1) from going denormal, which is slow.
+inline float fastTanh(float x, Precision precision = FINE) {
+  x = x < -9.0f ? -9.0f : (x > 9.0f ? 9.0f : x);
+  return 1.0f - 2.0f / (fastExp2(2.88539008f * x, precision) + 1.0f);
+}
+
+// (re, im) -> (magnitude, phase). the outputs may alias the inputs.
+void toPolar(const float* re, const float* im, float* magnitude, float* phase,
+             unsigned n);
+
+// (magnitude, phase) -> (re, im). the outputs may alias the inputs.
+void toRectangular(const float* magnitude, const float* phase, float* re,
+                   float* im, unsigned n);
+
+// the scalar functions over arrays. out may be in.
+void fastExp2(const float* in, float* out, unsigned n,
+              Precision precision = FINE);
+void fastLog2(const float* in, float* out, unsigned n,
+              Precision precision = FINE);
+void fastTanh(const float* in, float* out, unsigned n,
+              Precision precision = FINE);
+
+}  // namespace ap
+
+#endif
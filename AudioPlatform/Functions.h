@@ -9,10 +9,19 @@ namespace ap {
 
 void hann(Array& window, unsigned size);
 void hann(std::vector<float>& window, unsigned size);
+void hamming(Array& window, unsigned size);
+void hamming(std::vector<float>& window, unsigned size);
+void blackman(Array& window, unsigned size);
+void blackman(std::vector<float>& window, unsigned size);
 float mtof(float m);
 float ftom(float f);
 float dbtoa(float db);
 float atodb(float a);
+// the same over arrays; out may be in
+void mtof(const float* m, float* f, unsigned n);
+void ftom(const float* f, float* m, unsigned n);
+void dbtoa(const float* db, float* a, unsigned n);
+void atodb(const float* a, float* db, unsigned n);
 void normalize(float* data, unsigned size);
 float uniform(float low, float high);
 float uniform(float high = 1.0f);
@@ -18,9 +18,15 @@
 
 namespace ap {
 
-static unsigned channelCount = 2;
-static float sampleRate = 44100.0f;
-static unsigned blockSize = 512;
+// the engine's configuration. there is one of each for the whole program
+// (they are defined in source/Globals.cpp). set sampleRate and blockSize
+// before an AudioVisual is made to ask the device for something else; its
+// constructor settles sampleRate with the device, and they do not change
+// after that. blockSize must be a power of two. objects made before then
+// (globals, say) can be given the real rate with their prepare().
+extern unsigned channelCount;
+extern float sampleRate;
+extern unsigned blockSize;
 
 }  // namespace ap
 
@@ -2,14 +2,49 @@
 #define __AP_MIDI__
 
 #include <vector>
+#include "AudioPlatform/RingBuffer.h"
 #include "rtmidi/RtMidi.h"
 
 namespace ap {
 
+// MIDI input. RtMidi calls us back on its own thread as each message
+// arrives; we stamp it with the time and queue it for the audio thread,
+// without locks or allocation.
+//
+// in audio(), call block() first and then next() until it returns false.
+// each event comes with the sample offset within the block at which to act
+// on it: the events that arrived during the previous block, spread out over
+// this one as they were in time. so timing is exact to within a sample, at
+// the cost of one block of latency.
+//
 struct MIDI {
+  struct Event {
+    double time = 0;      // seconds, on std::chrono::steady_clock
+    unsigned offset = 0;  // in samples, within the current block
+    unsigned char size = 0;
+    unsigned char data[3] = {0, 0, 0};
+  };
+
   RtMidiIn *midiin = nullptr;
-  void setup();
+  RingBuffer<Event> queue;
+
+  void setup(unsigned port = 0, unsigned capacity = 1024);
+
+  // called from the audio thread
+  void block(unsigned frames);
+  bool next(Event &event);
+
+  // take the oldest message, without timing; message is empty if there are
+  // none. this does not allocate once message has grown to 3 bytes.
   void receive(std::vector<unsigned char> &message);
+
+  static double now();
+  static void callback(double delta, std::vector<unsigned char> *message,
+                       void *user);
+
+  // state of the current block
+  double begin = 0, end = 0;
+  unsigned frames = 0;
 };
 
 }  // namespace ap
@@ -0,0 +1,52 @@
+#ifndef __AP_MAPPED_WAV__
+#define __AP_MAPPED_WAV__
+
+#include <string>
+#include <vector>
+
+#include "AudioPlatform/Wav.h"
+
+namespace ap {
+
+// a .wav file mapped into memory (mmap) rather than read. the header is
+// parsed by dr_wav (drwav_init_memory) over the mapping, and nothing else is
+// read until it is used, so opening a large file takes no time and the
+// operating system shares its pages among every process that maps it.
+//
+// for 32-bit float data, view() returns a pointer straight into the mapped
+// file. for other formats, view() converts just the frames asked for into a
+// buffer, which stays valid until the next call to view().
+//
+struct MappedWav {
+  drwav wav{};
+  const unsigned char* map = nullptr;
+  size_t mapSize = 0;
+  const unsigned char* samples = nullptr;  // first byte of sample data
+
+  unsigned channels = 0;
+  unsigned long long frames = 0;
+  float sampleRate = 0;
+  std::vector<float> buffer;
+
+  // owns the mapping, so copies would unmap it twice
+  MappedWav() = default;
+  MappedWav(const MappedWav&) = delete;
+  MappedWav& operator=(const MappedWav&) = delete;
+  ~MappedWav() { close(); }
+
+  // returns false if the file can't be mapped or isn't a .wav
+  bool open(std::string filePath);
+  void close();
+
+  // true if view() points into the file, with no conversion. false, and
+  // view() returns nullptr, when no file is open.
+  bool direct() const;
+
+  // count interleaved frames starting at frame. frame + count must be no
+  // more than frames.
+  const float* view(unsigned long long frame, unsigned count);
+};
+
+}  // namespace ap
+
+#endif
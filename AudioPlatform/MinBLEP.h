@@ -0,0 +1,51 @@
+#ifndef __AP_MINBLEP__
+#define __AP_MINBLEP__
+
+#include <vector>
+
+namespace ap {
+
+// a minimum-phase band-limited step (MinBLEP), and its integral, as tables
+// of the residual: the difference between the band-limited version and the
+// naive one. adding a residual at the exact (sub-sample) time of a jump in
+// a naive waveform makes that jump band-limited.
+//
+// the step is made from a blackman-windowed sinc, taken to minimum phase
+// through the real cepstrum (zero the anti-causal half, the "liftering" in
+// example/minbleps.cpp) and integrated. it is built once, through ap::FFT;
+// no sample file is needed.
+//
+// the tables are polyphase: row p holds the residual at offsets j + p /
+// phases for j in [0, length), so adding one is a short contiguous loop,
+// interpolated between two rows.
+//
+struct MinBLEP {
+  static const unsigned zeroCrossings = 16;
+  static const unsigned length = 2 * zeroCrossings;  // samples
+  static const unsigned phases = 64;
+
+  // (phases + 1) rows of length; the last row is the first, a sample later
+  std::vector<float> stepResidual, rampResidual;
+
+  // the delay of the filter at DC, in samples. a band-limited ramp lags the
+  // naive one by this much, forever, so the ramp residual is taken against
+  // the naive ramp minus delay times its slope; a waveform with corners
+  // has to subtract that term itself.
+  float delay = 0;
+
+  MinBLEP();
+
+  // the one every oscillator shares, built the first time it is asked for
+  static const MinBLEP& table();
+
+  // add the residual of a jump of height that happened time samples (0..1)
+  // before out[0] to out[0] .. out[length - 1]
+  void step(float* out, float time, float height) const;
+
+  // the same for a change in slope (per sample) of a waveform
+  void ramp(float* out, float time, float slope) const;
+};
+
+}  // namespace ap
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef __AP_NOISE__
+#define __AP_NOISE__
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ap {
+
+// a small, fast generator of random numbers (PCG32, pcg-random.org) with its
+// own state, so it needs no lock and gives the same numbers for the same
+// seed every time.
+//
+struct Random {
+  uint64_t state = 0, stream = 0;
+
+  Random(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t sequence = 54) {
+    this->seed(seed, sequence);
+  }
+
+  // generators with different sequences give unrelated numbers, even from
+  // the same seed
+  void seed(uint64_t seed, uint64_t sequence = 54) {
+    state = 0;
+    stream = (sequence << 1) | 1;
+    next();
+    state += seed;
+    next();
+  }
+
+  uint32_t next() {
+    const uint64_t old = state;
+    state = old * 6364136223846793005ULL + stream;
+    const uint32_t shifted = uint32_t(((old >> 18) ^ old) >> 27);
+    const uint32_t rotation = uint32_t(old >> 59);
+    return (shifted >> rotation) | (shifted << ((-rotation) & 31));
+  }
+
+  // in [0, 1)
+  float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+  float uniform(float low, float high) {
+    return low + (high - low) * uniform();
+  }
+};
+
+// a new seed for each generator that is not given one. the sequence of
+// seeds is the same every run, so a program that makes its generators in
+// the same order renders the same noise.
+inline uint64_t nextSeed() {
+  static std::atomic<uint64_t> count{0};
+  return 0x9E3779B97F4A7C15ULL * ++count;
+}
+
+// uniform white noise in [-1, 1), from 8 xorshift generators run side by
+// side (one AVX2 register, or two SSE2 registers). the output does not
+// depend on how it is cut into blocks: values are made 8 at a time and the
+// ones a block does not use are kept for the next.
+//
+struct WhiteNoise {
+  uint32_t lane[8];
+  float spare[8];
+  unsigned used = 8;
+
+  WhiteNoise(uint64_t seed = nextSeed()) { this->seed(seed); }
+
+  void seed(uint64_t seed) {
+    Random random(seed);
+    for (unsigned k = 0; k < 8; ++k) {
+      do lane[k] = random.next();
+      while (lane[k] == 0);  // xorshift would stay at 0
+    }
+    used = 8;
+  }
+
+  float operator()() { return nextValue(); }
+  float nextValue() {
+    if (used == 8) {
+      generate(spare);
+      used = 0;
+    }
+    return spare[used++];
+  }
+
+  void process(float* out, unsigned n) {
+    unsigned i = 0;
+    while (i < n && used < 8) out[i++] = spare[used++];
+    for (; i + 8 <= n; i += 8) generate(out + i);
+    while (i < n) out[i++] = nextValue();
+  }
+
+  // 8 values, one from each lane. the top 23 bits of each lane become the
+  // mantissa of a float in [2, 4), and 3 is taken off.
+#if defined(__AVX2__)
+  void generate(float* out) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)lane);
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 13));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 17));
+    x = _mm256_xor_si256(x, _mm256_slli_epi32(x, 5));
+    _mm256_storeu_si256((__m256i*)lane, x);
+    const __m256i bits = _mm256_or_si256(_mm256_srli_epi32(x, 9),
+                                         _mm256_set1_epi32(0x40000000));
+    _mm256_storeu_ps(out, _mm256_sub_ps(_mm256_castsi256_ps(bits),
+                                        _mm256_set1_ps(3.0f)));
+  }
+#elif defined(__SSE2__)
+  void generate(float* out) {
+    for (unsigned k = 0; k < 8; k += 4) {
+      __m128i x = _mm_loadu_si128((const __m128i*)&lane[k]);
+      x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+      x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+      x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+      _mm_storeu_si128((__m128i*)&lane[k], x);
+      const __m128i bits =
+          _mm_or_si128(_mm_srli_epi32(x, 9), _mm_set1_epi32(0x40000000));
+      _mm_storeu_ps(&out[k],
+                    _mm_sub_ps(_mm_castsi128_ps(bits), _mm_set1_ps(3.0f)));
+    }
+  }
+#else
+  void generate(float* out) {
+    for (unsigned k = 0; k < 8; ++k) {
+      uint32_t x = lane[k];
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      lane[k] = x;
+      union {
+        uint32_t i;
+        float f;
+      } u;
+      u.i = (x >> 9) | 0x40000000;
+      out[k] = u.f - 3.0f;
+    }
+  }
+#endif
+};
+
+// white noise through Paul Kellet's filter, which is within 0.05 dB of
+// -3 dB per octave above 9 Hz (musicdsp.org, "pink noise filter")
+//
+struct PinkNoise {
+  WhiteNoise white;
+  float b0 = 0, b1 = 0, b2 = 0, b3 = 0, b4 = 0, b5 = 0, b6 = 0;
+
+  PinkNoise(uint64_t seed = nextSeed()) : white(seed) {}
+  void seed(uint64_t seed) { white.seed(seed); }
+
+  float operator()() { return nextValue(); }
+  float nextValue() { return filter(white()); }
+
+  void process(float* out, unsigned n) {
+    white.process(out, n);
+    for (unsigned i = 0; i < n; ++i) out[i] = filter(out[i]);
+  }
+
+  float filter(float w) {
+    b0 = 0.99886f * b0 + w * 0.0555179f;
+    b1 = 0.99332f * b1 + w * 0.0750759f;
+    b2 = 0.96900f * b2 + w * 0.1538520f;
+    b3 = 0.86650f * b3 + w * 0.3104856f;
+    b4 = 0.55000f * b4 + w * 0.5329522f;
+    b5 = -0.7616f * b5 - w * 0.0168980f;
+    const float pink = b0 + b1 + b2 + b3 + b4 + b5 + b6 + w * 0.5362f;
+    b6 = w * 0.115926f;
+    return pink * 0.11f;  // peaks near 1
+  }
+};
+
+// white noise through a leaky integrator: -6 dB per octave, down to about
+// 140 Hz, where the leak keeps it from wandering off
+//
+struct BrownNoise {
+  WhiteNoise white;
+  float y = 0;
+
+  BrownNoise(uint64_t seed = nextSeed()) : white(seed) {}
+  void seed(uint64_t seed) { white.seed(seed); }
+
+  float operator()() { return nextValue(); }
+  float nextValue() { return filter(white()); }
+
+  void process(float* out, unsigned n) {
+    white.process(out, n);
+    for (unsigned i = 0; i < n; ++i) out[i] = filter(out[i]);
+  }
+
+  float filter(float w) {
+    y = (y + 0.02f * w) * (1.0f / 1.02f);
+    return y * 3.5f;  // peaks near 1
+  }
+};
+
+}  // namespace ap
+
+#endif
@@ -0,0 +1,200 @@
+#ifndef __AP_OSCILLATOR_BANK__
+#define __AP_OSCILLATOR_BANK__
+
+#include "AudioPlatform/Globals.h"
+#include "AudioPlatform/Synths.h"
+#include "AudioPlatform/Types.h"
+
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ap {
+
+// a bank of table-lookup oscillators that all read the same table, summed to
+// a single output. this does what a vector<Sine> with a Line for each
+// frequency and gain does, but the phases, increments and gains are stored
+// as arrays (structure-of-arrays) so that 8 (AVX2) or 4 (SSE2) partials are
+// rendered at once. lookup is the same linear interpolation with looping
+// that Table::get does. the AVX2 path (with gathers) is only built with
+// ARCH="-mavx2 -mfma" or -march=native (see the Makefile); the default
+// build uses SSE2.
+//
+// frequency and gain changes ramp linearly over the next process() call,
+// or with time(), glide over about that many milliseconds whatever the
+// block size: each block ramps linearly through its share (n samples of
+// the glide time) of the way that is left.
+//
+struct OscillatorBank {
+  // per-partial state; padded with silent partials to a multiple of 8
+  std::vector<float> phase, increment, gain;
+  std::vector<float> incrementTarget, gainTarget;
+  std::vector<float> incrementStep, gainStep;
+
+  // a copy of the table with the first two samples repeated at the end, so
+  // that the looping lookup needs no branch, even when a phase is exactly 1
+  std::vector<float> table;
+  unsigned size = 0;
+  unsigned count = 0;
+  float milliseconds = 0;
+
+  void setup(unsigned partials) {
+    Sine sine;
+    setup(partials, sine);
+  }
+
+  void setup(unsigned partials, const Array& wave) {
+    size = wave.size;
+    table.resize(size + 2);
+    for (unsigned i = 0; i < size; ++i) table[i] = wave.data[i];
+    table[size] = wave.data[0];
+    table[size + 1] = wave.data[size > 1 ? 1 : 0];
+
+    count = partials;
+    unsigned padded = (partials + 7) & ~7u;
+    for (auto* v : {&phase, &increment, &gain, &incrementTarget, &gainTarget,
+                    &incrementStep, &gainStep})
+      v->assign(padded, 0.0f);
+  }
+
+  // set the target frequency (Hz) and gain of partial k
+  void set(unsigned k, float hz, float g) {
+    incrementTarget[k] = hz / sampleRate;
+    gainTarget[k] = g;
+  }
+
+  // how long changes glide; 0 (the default) is one process() call
+  void time(float milliseconds) { this->milliseconds = milliseconds; }
+
+  // write the sum of all the partials into out
+  void process(float* out, unsigned n) {
+    const unsigned padded = phase.size();
+    const float glide = milliseconds / 1000.0f * sampleRate;
+    const bool land = glide <= n;
+    const float scale = 1.0f / (land ? n : glide);
+    for (unsigned k = 0; k < padded; ++k) {
+      incrementStep[k] = (incrementTarget[k] - increment[k]) * scale;
+      gainStep[k] = (gainTarget[k] - gain[k]) * scale;
+    }
+
+    for (unsigned i = 0; i < n; ++i) out[i] = nextValue();
+
+    // land exactly on the targets, if the glide is over
+    for (unsigned k = 0; k < padded; ++k) {
+      if (land) {
+        increment[k] = incrementTarget[k];
+        gain[k] = gainTarget[k];
+      }
+      incrementStep[k] = gainStep[k] = 0.0f;
+    }
+  }
+
+#if defined(__AVX2__)
+  float nextValue() {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 length = _mm256_set1_ps(size);
+    __m256 sum = _mm256_setzero_ps();
+    for (unsigned k = 0; k < phase.size(); k += 8) {
+      __m256 p = _mm256_loadu_ps(&phase[k]);
+      __m256 inc = _mm256_loadu_ps(&increment[k]);
+      __m256 g = _mm256_loadu_ps(&gain[k]);
+
+      // interpolated lookup, as in Table::get
+      __m256 index = _mm256_mul_ps(p, length);
+      __m256i j = _mm256_cvttps_epi32(index);
+      __m256 t = _mm256_sub_ps(index, _mm256_cvtepi32_ps(j));
+      __m256 x0 = _mm256_i32gather_ps(&table[0], j, 4);
+      __m256 x1 = _mm256_i32gather_ps(&table[1], j, 4);
+      __m256 v = _mm256_add_ps(_mm256_mul_ps(x1, t),
+                               _mm256_mul_ps(x0, _mm256_sub_ps(one, t)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(v, g));
+
+      // advance the phase, as in Phasor::nextValue
+      p = _mm256_add_ps(p, inc);
+      __m256 over = _mm256_cmp_ps(p, one, _CMP_GT_OQ);
+      p = _mm256_sub_ps(p, _mm256_and_ps(over, one));
+      __m256 under = _mm256_cmp_ps(p, zero, _CMP_LT_OQ);
+      p = _mm256_add_ps(p, _mm256_and_ps(under, one));
+      _mm256_storeu_ps(&phase[k], p);
+
+      // ramp
+      _mm256_storeu_ps(&increment[k],
+                       _mm256_add_ps(inc, _mm256_loadu_ps(&incrementStep[k])));
+      _mm256_storeu_ps(&gain[k],
+                       _mm256_add_ps(g, _mm256_loadu_ps(&gainStep[k])));
+    }
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(sum),
+                          _mm256_extractf128_ps(sum, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+  }
+#elif defined(__SSE2__)
+  float nextValue() {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 length = _mm_set1_ps(size);
+    __m128 sum = _mm_setzero_ps();
+    for (unsigned k = 0; k < phase.size(); k += 4) {
+      __m128 p = _mm_loadu_ps(&phase[k]);
+      __m128 inc = _mm_loadu_ps(&increment[k]);
+      __m128 g = _mm_loadu_ps(&gain[k]);
+
+      // interpolated lookup, as in Table::get; SSE2 has no gather
+      __m128 index = _mm_mul_ps(p, length);
+      __m128i j = _mm_cvttps_epi32(index);
+      __m128 t = _mm_sub_ps(index, _mm_cvtepi32_ps(j));
+      alignas(16) int at[4];
+      _mm_store_si128((__m128i*)at, j);
+      __m128 x0 = _mm_setr_ps(table[at[0]], table[at[1]], table[at[2]],
+                              table[at[3]]);
+      __m128 x1 = _mm_setr_ps(table[at[0] + 1], table[at[1] + 1],
+                              table[at[2] + 1], table[at[3] + 1]);
+      __m128 v = _mm_add_ps(_mm_mul_ps(x1, t),
+                            _mm_mul_ps(x0, _mm_sub_ps(one, t)));
+      sum = _mm_add_ps(sum, _mm_mul_ps(v, g));
+
+      // advance the phase, as in Phasor::nextValue
+      p = _mm_add_ps(p, inc);
+      p = _mm_sub_ps(p, _mm_and_ps(_mm_cmpgt_ps(p, one), one));
+      p = _mm_add_ps(p, _mm_and_ps(_mm_cmplt_ps(p, zero), one));
+      _mm_storeu_ps(&phase[k], p);
+
+      // ramp
+      _mm_storeu_ps(&increment[k],
+                    _mm_add_ps(inc, _mm_loadu_ps(&incrementStep[k])));
+      _mm_storeu_ps(&gain[k], _mm_add_ps(g, _mm_loadu_ps(&gainStep[k])));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+  }
+#else
+  float nextValue() {
+    float sum = 0;
+    for (unsigned k = 0; k < phase.size(); ++k) {
+      const float index = phase[k] * size;
+      const unsigned j = index;
+      const float t = index - j;
+      sum += (table[j + 1] * t + table[j] * (1 - t)) * gain[k];
+
+      phase[k] += increment[k];
+      if (phase[k] > 1.0f) phase[k] -= 1.0f;
+      if (phase[k] < 0.0f) phase[k] += 1.0f;
+
+      increment[k] += incrementStep[k];
+      gain[k] += gainStep[k];
+    }
+    return sum;
+  }
+#endif
+};
+
+}  // namespace ap
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef __AP_RING_BUFFER__
+#define __AP_RING_BUFFER__
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace ap {
+
+// a fixed-capacity FIFO from one thread (the writer) to one other thread (the
+// reader), without locks or allocation. the capacity is rounded up to a power
+// of two. writes that do not fit fail (or are cut short); nothing blocks.
+//
+// writer and reader each own a counter that only ever goes up; the number of
+// items in the buffer is the difference. an index into the storage is a
+// counter modulo the capacity.
+//
+template <typename T>
+struct RingBuffer {
+  std::vector<T> data;
+  unsigned long mask = 0;
+  std::atomic<unsigned long> written{0}, taken{0};
+
+  // allocate; call this before either thread starts using the buffer
+  void setup(unsigned long capacity) {
+    unsigned long size = 1;
+    while (size < capacity) size <<= 1;
+    data.assign(size, T());
+    mask = size - 1;
+    reset();
+  }
+
+  // empty the buffer; only when neither thread is using it
+  void reset() {
+    written.store(0);
+    taken.store(0);
+  }
+
+  unsigned long capacity() const { return data.size(); }
+
+  // items the reader may take
+  unsigned long available() const {
+    return written.load(std::memory_order_acquire) -
+           taken.load(std::memory_order_relaxed);
+  }
+
+  // items the writer may add
+  unsigned long space() const {
+    return capacity() - (written.load(std::memory_order_relaxed) -
+                         taken.load(std::memory_order_acquire));
+  }
+
+  //
+  // writer
+  //
+
+  bool push(const T& t) {
+    const unsigned long w = written.load(std::memory_order_relaxed);
+    if (w - taken.load(std::memory_order_acquire) == capacity()) return false;
+    data[w & mask] = t;
+    written.store(w + 1, std::memory_order_release);
+    return true;
+  }
+
+  // add up to n items; returns how many were added
+  unsigned long write(const T* t, unsigned long n) {
+    const unsigned long w = written.load(std::memory_order_relaxed);
+    n = std::min(n, capacity() - (w - taken.load(std::memory_order_acquire)));
+    for (unsigned long i = 0; i < n; ++i) data[(w + i) & mask] = t[i];
+    written.store(w + n, std::memory_order_release);
+    return n;
+  }
+
+  //
+  // reader
+  //
+
+  // the oldest item, without taking it; only when available()
+  const T& peek() const {
+    return data[taken.load(std::memory_order_relaxed) & mask];
+  }
+
+  bool pop(T& t) {
+    const unsigned long r = taken.load(std::memory_order_relaxed);
+    if (written.load(std::memory_order_acquire) == r) return false;
+    t = data[r & mask];
+    taken.store(r + 1, std::memory_order_release);
+    return true;
+  }
+
+  // take up to n items; returns how many were taken
+  unsigned long read(T* t, unsigned long n) {
+    const unsigned long r = taken.load(std::memory_order_relaxed);
+    n = std::min(n, written.load(std::memory_order_acquire) - r);
+    for (unsigned long i = 0; i < n; ++i) t[i] = data[(r + i) & mask];
+    taken.store(r + n, std::memory_order_release);
+    return n;
+  }
+
+  // drop up to n items; returns how many were dropped
+  unsigned long skip(unsigned long n) {
+    const unsigned long r = taken.load(std::memory_order_relaxed);
+    n = std::min(n, written.load(std::memory_order_acquire) - r);
+    taken.store(r + n, std::memory_order_release);
+    return n;
+  }
+};
+
+}  // namespace ap
+
+#endif
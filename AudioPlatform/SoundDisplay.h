@@ -4,51 +4,55 @@
 #include "AudioPlatform/FFT.h"
 #include "AudioPlatform/Functions.h"
 #include "AudioPlatform/Globals.h"
+#include "AudioPlatform/TripleBuffer.h"
 #include "AudioPlatform/Types.h"
 
 #include <string.h>
-#include <mutex>
 #include <vector>
 
 namespace ap {
 
 struct SoundDisplay {
   FFT fft;
-  std::mutex m;
-  std::vector<float> history, _history;
+  TripleBuffer history;
+  std::vector<float> copy;
   Array hann_window;
+  std::vector<float> note;  // the MIDI note of each bin
   unsigned n = 0;
 
   void setup(unsigned historySize) {
-    history.resize(historySize, 0);
-    _history.resize(historySize, 0);
+    history.setup(historySize);
+    copy.resize(historySize, 0);
     hann(hann_window, historySize);
     fft.setup(historySize);
+
+    note.resize(fft.magnitude.size());
+    for (unsigned i = 0; i < note.size(); ++i)
+      note[i] = sampleRate * i / note.size() / 2;
+    ftom(&note[0], &note[0], note.size());
   }
 
   void operator()(float value) {
-    _history[n] = value;
+    history.write()[n] = value;
     // if the history buffer is full...
     n++;
     if (n >= history.size()) {
       // start a new history
       n = 0;
 
-      // *maybe* copy the history buffer for the visual thread to use
-      if (m.try_lock()) {
-        memcpy(&history[0], &_history[0], history.size() * sizeof(float));
-        m.unlock();
-      }
+      // hand the history to the visual thread; this never waits, so the
+      // audio thread never blocks on the visual thread
+      history.publish();
     }
   }
 
   void operator()() {
-    // get the lock (mutex); this will block, waiting for the audio thread to
-    // release the lock. lock() waits while try_lock() does not.
-    m.lock();
+    // get the newest complete history. the audio thread will not touch this
+    // buffer until we call read() again, so we need no lock.
+    const float* frame = history.read();
 
     // use the history buffer to draw the waveform
-    ImGui::PlotLines("Waveform", &history[0], history.size(), 0, "", FLT_MAX,
+    ImGui::PlotLines("Waveform", frame, history.size(), 0, "", FLT_MAX,
                      FLT_MAX, ImVec2(0, 50));
 
     // if we have overview data, show it
@@ -58,26 +62,18 @@ struct SoundDisplay {
     //                   FLT_MAX, ImVec2(0, 50));
     //}
 
-    // make a copy
-    float copy[history.size()];
-    memcpy(copy, &history[0], history.size() * sizeof(float));
-    // window the data
-    for (unsigned i = 0; i < history.size(); ++i) copy[i] *= hann_window[i];
+    // window a copy of the data
+    for (unsigned i = 0; i < history.size(); ++i)
+      copy[i] = frame[i] * hann_window[i];
     // take the FFT
     fft.forward(&copy[0]);
 
-    // release the lock; this is important. if you don't release the lock,
-    // then the audio thread can never get the lock, so it can never copy any
-    // history and we'll stop getting updates. we can release the lock as soon
-    // as we are done using the history vector
-    m.unlock();
-
     // convert to dB scale on the y axis
-    for (auto& f : fft.magnitude) f = atodb(f);
+    atodb(fft.magnitude.data(), fft.magnitude.write(), fft.magnitude.size());
 
     // draw the spectrum, linear in frequency
-    ImGui::PlotLines("Spectrum", &fft.magnitude[0], fft.magnitude.size(), 0, "",
-                     FLT_MAX, FLT_MAX, ImVec2(0, 50));
+    ImGui::PlotLines("Spectrum", fft.magnitude.data(), fft.magnitude.size(), 0,
+                     "", FLT_MAX, FLT_MAX, ImVec2(0, 50));
 
     // draw the spectrum, LOG in frequency
     ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -100,12 +96,8 @@ struct SoundDisplay {
     };
 
     // draw the spectrum with lines
-    float _n = ftom(sampleRate * 1 / fft.magnitude.size() / 2);
-    for (unsigned i = 2; i < fft.magnitude.size(); ++i) {
-      float n = ftom(sampleRate * i / fft.magnitude.size() / 2);
-      line(_n, fft.magnitude[i - 1], n, fft.magnitude[i]);
-      _n = n;
-    }
+    for (unsigned i = 2; i < fft.magnitude.size(); ++i)
+      line(note[i - 1], fft.magnitude[i - 1], note[i], fft.magnitude[i]);
   }
 };
 
@@ -0,0 +1,76 @@
+#ifndef __AP_STREAM_PLAYER__
+#define __AP_STREAM_PLAYER__
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AudioPlatform/RingBuffer.h"
+#include "AudioPlatform/Wav.h"
+
+namespace ap {
+
+// plays one channel of a .wav file straight from disk. a background thread
+// decodes the file a chunk at a time with drwav_read_f32 into a ring buffer
+// that the audio thread plays from, so memory is bounded by the buffer
+// rather than the length of the file. load() decodes the first chunk itself,
+// so playback can start right away.
+//
+// seek() may be called from any thread; the reader thread moves the file
+// with drwav_seek_to_sample and the audio thread skips whatever it had
+// buffered before the seek, and starts interpolating afresh.
+//
+// if the reader thread falls behind, process() plays silence for the
+// samples it does not have and counts them in underruns.
+//
+struct StreamPlayer {
+  drwav* wav = nullptr;
+  unsigned channel = 0, channels = 0;
+  unsigned long long frames = 0;  // length of the file, in frames
+  float playbackRate = 0;         // the file's sample rate
+  std::atomic<bool> loop{true};   // may be set from any thread
+
+  RingBuffer<float> ring;
+  std::vector<float> chunk, mono;  // the reader thread's
+  std::thread thread;
+  std::atomic<bool> running{false}, finished{false};
+  std::atomic<long long> seekRequest{-1};
+  std::atomic<unsigned long> boundary{0};
+  unsigned long seen = 0;  // the last boundary the audio thread acted on
+  unsigned long underruns = 0;
+
+  // interpolation state for process(out, rate, n)
+  float x0 = 0, x1 = 0, position = 1;
+
+  ~StreamPlayer() { close(); }
+
+  // buffer is in frames; chunkSize is how many frames are read at a time
+  void load(std::string filePath, unsigned channel = 0,
+            unsigned buffer = 1 << 16, unsigned chunkSize = 4096);
+  void close();
+
+  // move to a frame of the file
+  void seek(unsigned long long frame) { seekRequest.store(frame); }
+
+  // true when the file has ended (and loop is off) and everything buffered
+  // has been played
+  bool done() const { return finished.load() && !ring.available(); }
+
+  // play at the file's sample rate, one sample out per frame of the file
+  void process(float* out, unsigned n);
+
+  // play at a rate (1 is normal speed, adjusted for the file's sample rate)
+  // for each sample, with linear interpolation. rates less than 0 are taken
+  // as 0; a stream cannot play backwards.
+  void process(float* out, const float* rate, unsigned n);
+
+  // the rest is internal
+  bool fill();
+  bool skipStale();
+  float next();
+};
+
+}  // namespace ap
+
+#endif
@@ -2,19 +2,35 @@
 #define __AP_SYNTHS__
 
 #include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "Wav.h"
 
 #include "AudioPlatform/Globals.h"
+#include "AudioPlatform/MinBLEP.h"
 #include "AudioPlatform/Types.h"
 
 namespace ap {
 
+// objects that turn times or frequencies into something per sample keep what
+// they were given, and prepare() works it out again for the sampleRate now.
+// anything set up before AudioVisual::start() settles the rate (in a
+// constructor, say) should be prepared in setup().
+//
 struct Timer {
-  float phase = 0.0f, increment = 0.0f;
-  void period(float s) { increment = 1.0f / (s * sampleRate * 2); }
+  float phase = 0.0f, increment = 0.0f, seconds = 0.0f;
+  void period(float s) {
+    seconds = s;
+    increment = 1.0f / (s * sampleRate * 2);
+  }
   void ms(float ms) { period(ms / 1000); }
   void frequency(float hz) { period(1 / hz); }
+  void prepare() {
+    if (seconds != 0.0f) period(seconds);
+  }
 
   virtual bool operator()() { return nextValue(); }
   virtual bool nextValue() {
@@ -31,18 +47,47 @@ struct Timer {
   }
 };
 
+// every generator below has a block interface, process(out, n), next to the
+// per-sample nextValue(). the block loops never make virtual calls, so a
+// block costs one dispatch rather than one per sample, and the waveshaping
+// passes are simple enough for the compiler to vectorize. note that
+// process() does not call nextValue(); a subclass that overrides
+// nextValue() must also provide its own process().
+//
 struct Phasor {
-  float phase = 0.0f, increment = 0.0f;
-  void frequency(float hz) { increment = hz / sampleRate; }
+  float phase = 0.0f, increment = 0.0f, hz = 0.0f;
+  void frequency(float hz) {
+    this->hz = hz;
+    increment = hz / sampleRate;
+  }
   void period(float s) { frequency(1 / s); }
+  void prepare() { frequency(hz); }
   virtual float operator()() { return nextValue(); }
-  virtual float nextValue() {
+  virtual float nextValue() { return step(); }
+
+  // non-virtual version of nextValue()
+  float step() {
     float returnValue = phase;
     phase += increment;
     if (phase > 1.0f) phase -= 1.0f;
     if (phase < 0.0f) phase += 1.0f;  // sure; handle negative frequency
     return returnValue;
   }
+
+  void process(float* out, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) out[i] = step();
+  }
+
+  // like above, but with a frequency (Hz) for each sample. afterwards, the
+  // frequency is the last one, as if set with frequency()
+  void process(float* out, const float* hz, unsigned n) {
+    const float scale = 1.0f / sampleRate;
+    for (unsigned i = 0; i < n; ++i) {
+      increment = hz[i] * scale;
+      out[i] = step();
+    }
+    if (n > 0) this->hz = hz[n - 1];
+  }
 };
 
 struct Table : Phasor, Array {
@@ -55,24 +100,80 @@ struct Table : Phasor, Array {
     Phasor::nextValue();
     return v;
   }
+
+  void process(float* out, unsigned n) {
+    Phasor::process(out, n);
+    lookup(out, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    Phasor::process(out, hz, n);
+    lookup(out, n);
+  }
+
+  // replace a block of phases with table values; this is Array::get, inlined
+  void lookup(float* out, unsigned n) const {
+    for (unsigned i = 0; i < n; ++i) {
+      const float index = out[i] * size;
+      const unsigned j = index;  // floor; phase is never negative
+      const float x0 = data[j];
+      const float x1 = data[(j == (size - 1)) ? 0 : j + 1];  // looping
+      const float t = index - j;
+      out[i] = x1 * t + x0 * (1 - t);
+    }
+  }
 };
 
+// tables that many oscillators read and none write, built the first time a
+// size is asked for and shared from then on. each is freed when the last
+// oscillator using it is.
+struct TableCache {
+  std::mutex mutex;
+  std::map<unsigned, std::weak_ptr<Array>> table;
+
+  // the table of a size; build fills it in, if it has to be made
+  template <typename Build>
+  std::shared_ptr<Array> get(unsigned size, Build build) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<Array> t = table[size].lock();
+    if (!t) {
+      t = std::make_shared<Array>();
+      t->resize(size);
+      build(t->data, size);
+      table[size] = t;
+    }
+    return t;
+  }
+};
+
+// every Noise of a size reads the same table, each from a random place
 struct Noise : Table {
-  Noise(unsigned size = 20 * 44100) {
-    resize(size);
-    for (unsigned i = 0; i < size; ++i)
-      data[i] = 2.0f * (random() / float(RAND_MAX)) - 1.0f;
+  std::shared_ptr<Array> shared;
+
+  Noise(unsigned size = 20 * 44100) : Table(0) {
+    static TableCache cache;
+    shared = cache.get(size, [](float* data, unsigned size) {
+      for (unsigned i = 0; i < size; ++i)
+        data[i] = 2.0f * (random() / float(RAND_MAX)) - 1.0f;
+    });
+    borrow(shared->data, size);
+    phase = (random() % size) / float(size);
 
     // the formula above should already  be normalized
     // normalize(data, size);
   }
 };
 
+// every Sine of a size reads the same table
 struct Sine : Table {
-  Sine(unsigned size = 10000) {
-    const float pi2 = M_PI * 2;
-    resize(size);
-    for (unsigned i = 0; i < size; ++i) data[i] = sinf(i * pi2 / size);
+  std::shared_ptr<Array> shared;
+
+  Sine(unsigned size = 10000) : Table(0) {
+    static TableCache cache;
+    shared = cache.get(size, [](float* data, unsigned size) {
+      const float pi2 = M_PI * 2;
+      for (unsigned i = 0; i < size; ++i) data[i] = sinf(i * pi2 / size);
+    });
+    borrow(shared->data, size);
   }
 };
 
@@ -94,10 +195,11 @@ struct SamplePlayer : Table {
 
     //
     playbackRate = sampleRate;
-    resize(totalSampleCount);
+    resize(totalSampleCount / channelCount);  // frames, not samples
     //
     for (unsigned i = 0; i < size; ++i)
       data[i] = pSampleData[channelCount * i + channel];
+    drwav_free(pSampleData);
 
     frequency(1.0f);
 
@@ -121,6 +223,93 @@ struct SamplePlayer : Table {
   }
 
   void frequency(float f) { Phasor::frequency(f * playbackRate / size); }
+
+  using Table::process;
+
+  // like Table::process, but with a playback rate (1 is normal speed) for
+  // each sample rather than a frequency
+  void process(float* out, const float* rate, unsigned n) {
+    const float scale = playbackRate / size / sampleRate;
+    for (unsigned i = 0; i < n; ++i) {
+      increment = rate[i] * scale;
+      out[i] = step();
+    }
+    lookup(out, n);
+  }
+};
+
+// plays every channel of a .wav file at once, one output block per channel.
+// the file is decoded once into a SampleBuffer. the phase, and from it the
+// index and fraction into the samples, are computed once per sample and
+// shared by all the channels.
+struct MultiSamplePlayer : Phasor {
+  SampleBuffer buffer;
+  float playbackRate = 0;
+  std::vector<unsigned> index;
+  std::vector<float> fraction;
+
+  void load(std::string filePath) {
+    if (!buffer.load(filePath.c_str())) {
+      printf("ERROR: failed to open %s\n", filePath.c_str());
+      exit(1);
+    }
+    playbackRate = buffer.sampleRate;
+    frequency(1.0f);
+    printf("%s -> %u channels of %u samples @ %f Hz\n", filePath.c_str(),
+           buffer.channels, buffer.frames, playbackRate);
+  }
+
+  void frequency(float f) {
+    Phasor::frequency(f * playbackRate / buffer.frames);
+  }
+
+  // out has a block for each channel of the file
+  void process(float* const* out, unsigned n) {
+    reserve(n);
+    Phasor::process(&fraction[0], n);
+    render(out, n);
+  }
+
+  // like above, but with a playback rate (1 is normal speed) for each sample
+  void process(float* const* out, const float* rate, unsigned n) {
+    reserve(n);
+    const float scale = playbackRate / buffer.frames / sampleRate;
+    for (unsigned i = 0; i < n; ++i) {
+      increment = rate[i] * scale;
+      fraction[i] = step();
+    }
+    render(out, n);
+  }
+
+  // allocate for blocks of n samples, so that process() doesn't have to
+  void reserve(unsigned n) {
+    if (index.size() < n) {
+      index.resize(n);
+      fraction.resize(n);
+    }
+  }
+
+  // turn the phases in fraction into index and fraction, then look up each
+  // channel
+  void render(float* const* out, unsigned n) {
+    const unsigned frames = buffer.frames;
+    unsigned* j = &index[0];
+    float* t = &fraction[0];
+    for (unsigned i = 0; i < n; ++i) {
+      const float x = t[i] * frames;
+      j[i] = x;
+      t[i] = x - j[i];
+      if (j[i] >= frames) j[i] = 0;  // phase was exactly 1
+    }
+    for (unsigned c = 0; c < buffer.channels; ++c) {
+      const float* d = buffer[c];
+      float* o = out[c];
+      for (unsigned i = 0; i < n; ++i) {
+        const float x0 = d[j[i]];
+        o[i] = x0 + (d[j[i] + 1] - x0) * t[i];
+      }
+    }
+  }
 };
 
 struct Line {
@@ -142,6 +331,9 @@ struct Line {
   }
   void set(float target) { set(value, target, milliseconds); }
 
+  // a glide in progress starts over from where it is
+  void prepare() { set(); }
+
   bool done() {
     if (value == target) return true;
     // if the increment is negative, then we're done when the value is lower
@@ -160,16 +352,57 @@ struct Line {
       value += increment;
     return returnValue;
   }
+
+  // the samples left before the target are value + i * increment, so a block
+  // needs no checks; the rest are the target
+  void process(float* out, unsigned n) {
+    unsigned i = 0;
+    if (!done()) {
+      const float steps = ceilf((target - value) / increment);
+      const unsigned m = steps < n ? unsigned(steps) : n;
+      for (; i < m; ++i) out[i] = value + i * increment;
+      value = m < n ? target : value + m * increment;
+    }
+    for (; i < n; ++i) out[i] = target;
+  }
 };
 
 struct Saw : Phasor {
   float nextValue() { return Phasor::nextValue() * 2.0f - 1.0f; }
   float operator()() { return nextValue(); }
+
+  void process(float* out, unsigned n) {
+    Phasor::process(out, n);
+    shape(out, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    Phasor::process(out, hz, n);
+    shape(out, n);
+  }
+
+  // phase to waveform
+  static void shape(float* out, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) out[i] = out[i] * 2.0f - 1.0f;
+  }
 };
 
 struct Square : Phasor {
   float nextValue() { return Phasor::nextValue() > 0.5f ? 1.0f : -1.0f; }
   float operator()() { return nextValue(); }
+
+  void process(float* out, unsigned n) {
+    Phasor::process(out, n);
+    shape(out, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    Phasor::process(out, hz, n);
+    shape(out, n);
+  }
+
+  // phase to waveform
+  static void shape(float* out, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) out[i] = out[i] > 0.5f ? 1.0f : -1.0f;
+  }
 };
 
 struct Impulse : Phasor {
@@ -188,6 +421,23 @@ struct Triangle : Saw {
     return (f > 1.0f) ? 2.0f - f : ((f < -1.0f) ? -2.0f - f : f);
   }
   float operator()() { return nextValue(); }
+
+  void process(float* out, unsigned n) {
+    Phasor::process(out, n);
+    shape(out, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    Phasor::process(out, hz, n);
+    shape(out, n);
+  }
+
+  // phase to waveform
+  static void shape(float* out, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) {
+      float f = out[i] * 4.0f - 2.0f;
+      out[i] = (f > 1.0f) ? 2.0f - f : ((f < -1.0f) ? -2.0f - f : f);
+    }
+  }
 };
 
 struct MultiSynth : Phasor {
@@ -208,6 +458,44 @@ struct MultiSynth : Phasor {
   }
   float operator()() { return nextValue(); }
 
+  // the waveform switch happens once per block rather than once per sample
+  void process(float* out, unsigned n) {
+    if (type == 3) {
+      for (unsigned i = 0; i < n; ++i) out[i] = impulse();
+      return;
+    }
+    Phasor::process(out, n);
+    shape(out, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    if (type == 3) {
+      const float scale = 1.0f / sampleRate;
+      for (unsigned i = 0; i < n; ++i) {
+        increment = hz[i] * scale;
+        out[i] = impulse();
+      }
+      return;
+    }
+    Phasor::process(out, hz, n);
+    shape(out, n);
+  }
+
+  // phase to waveform, for all but the impulse
+  void shape(float* out, unsigned n) const {
+    switch (type) {
+      default:
+      case 0:
+        Saw::shape(out, n);
+        break;
+      case 1:
+        Triangle::shape(out, n);
+        break;
+      case 2:
+        Square::shape(out, n);
+        break;
+    }
+  }
+
   float square() { return Phasor::nextValue() > 0.5f ? 1.0f : -1.0f; }
 
   float saw() { return Phasor::nextValue() * 2.0f - 1.0f; }
@@ -236,36 +524,298 @@ struct HardSyncMultiSynth : MultiSynth {
   }
 };
 
-class Biquad {
-  // Audio EQ Cookbook
-  // http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
+// band-limited saw, pulse and triangle. the naive waveform is rendered from
+// the phase as usual; each jump (and, for the triangle, each corner) then
+// gets a MinBLEP residual, placed at its exact sub-sample time. residuals
+// are summed into a buffer that carries over from block to block, so a
+// block is one short scalar pass that finds the edges, and then loops that
+// vectorize.
+//
+// hard sync: render() can write, for each sample, how long before the next
+// sample (0..1) the oscillator wrapped, or -1 if it did not. given that as
+// reset, another oscillator restarts its cycle at those times. see
+// BlepHardSync.
+//
+struct BlepOscillator : Phasor {
+  enum Type { SAW, PULSE, TRIANGLE };
+  Type type = SAW;
+  float width = 0.5f;  // of the pulse, 0..1; 0.5 is a square
+
+  const MinBLEP* blep = &MinBLEP::table();
+  std::vector<float> correction;
+
+  BlepOscillator(Type type = SAW) : type(type) { reserve(blockSize); }
+
+  void prepare() {
+    Phasor::prepare();
+    reserve(blockSize);
+  }
 
-  // x[n-1], x[n-2], y[n-1], y[n-2]
-  float x1, x2, y1, y2;
+  virtual float operator()() { return nextValue(); }
+  virtual float nextValue() {
+    float f;
+    render(&f, nullptr, nullptr, nullptr, 1);
+    return f;
+  }
 
-  // filter coefficients
-  float b0, b1, b2, a1, a2;
+  void process(float* out, unsigned n) {
+    render(out, nullptr, nullptr, nullptr, n);
+  }
+  void process(float* out, const float* hz, unsigned n) {
+    render(out, hz, nullptr, nullptr, n);
+  }
 
- public:
-  float operator()(float x0) {
-    // Direct Form 1, normalized...
-    float y0 = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-    y2 = y1;
-    y1 = y0;
-    x2 = x1;
-    x1 = x0;
-    return y0;
+  // hz (a frequency for each sample), reset and wrapped may each be nullptr
+  void render(float* out, const float* hz, const float* reset, float* wrapped,
+              unsigned n) {
+    reserve(n);
+    const float scale = 1.0f / sampleRate;
+    for (unsigned i = 0; i < n; ++i) {
+      if (hz) increment = hz[i] * scale;
+      const float inc = increment;
+      out[i] = phase;
+      float w = -1;
+      if (reset && reset[i] >= 0) {
+        // run up to the reset, jump to the start of the cycle (the end, when
+        // going backwards) and run on from there
+        const float d = reset[i];
+        float q = phase + inc * (1 - d);
+        cross(phase, q, inc, d, i + 1);
+        if (q >= 1.0f) q -= 1.0f;
+        if (q < 0.0f) q += 1.0f;
+        const float start = inc < 0 ? 1.0f : 0.0f;
+        edge(i + 1, d, value(start) - value(q),
+             (slope(start) - slope(q)) * inc);
+        phase = start + inc * d;
+        cross(start, phase, inc, 0, i + 1);
+        w = d;
+      } else {
+        float b = phase + inc;
+        cross(phase, b, inc, 0, i + 1);
+        if (b >= 1.0f) {
+          w = (b - 1.0f) / inc;
+          b -= 1.0f;
+        }
+        if (b < 0.0f) {
+          w = b / inc;
+          b += 1.0f;
+        }
+        phase = b;
+      }
+      if (wrapped) wrapped[i] = w;
+    }
+    shape(out, hz, n);
+
+    // add the residuals that are due and keep the rest for the next block
+    float* c = &correction[0];
+    for (unsigned i = 0; i < n; ++i) out[i] += c[i];
+    for (unsigned i = 0; i < MinBLEP::length; ++i) c[i] = c[n + i];
+    for (unsigned i = 0; i < n; ++i) c[MinBLEP::length + i] = 0;
   }
 
-  Biquad() { apf(1000.0f, 0.5f); }
+  // allocate for blocks of up to n samples
+  void reserve(unsigned n) {
+    if (correction.size() < n + MinBLEP::length)
+      correction.resize(n + MinBLEP::length, 0.0f);
+  }
+
+  // the naive waveform and its slope (per cycle) at a phase in [0, 1]; at 1
+  // these are the values just before the cycle ends
+  float value(float p) const {
+    switch (type) {
+      default:
+      case SAW:
+        return p * 2.0f - 1.0f;
+      case PULSE:
+        return p >= width ? 1.0f : -1.0f;
+      case TRIANGLE: {
+        float f = p * 4.0f - 2.0f;
+        return (f > 1.0f) ? 2.0f - f : ((f < -1.0f) ? -2.0f - f : f);
+      }
+    }
+  }
+  float slope(float p) const {
+    switch (type) {
+      default:
+      case SAW:
+        return 2.0f;
+      case PULSE:
+        return 0.0f;
+      case TRIANGLE:
+        return (p < 0.25f || p >= 0.75f) ? -4.0f : 4.0f;
+    }
+  }
+
+  // phase to waveform. the ramp residual is taken against the waveform
+  // minus delay times its slope (see MinBLEP.h), so that is taken off here;
+  // for the saw it is only an offset, but without it the saw has DC
+  void shape(float* out, const float* hz, unsigned n) const {
+    const float k = blep->delay;
+    const float scale = 1.0f / sampleRate;
+    switch (type) {
+      default:
+      case SAW:
+        for (unsigned i = 0; i < n; ++i) {
+          const float inc = hz ? hz[i] * scale : increment;
+          out[i] = out[i] * 2.0f - 1.0f - 2.0f * k * inc;
+        }
+        break;
+      case PULSE:
+        for (unsigned i = 0; i < n; ++i)
+          out[i] = out[i] >= width ? 1.0f : -1.0f;
+        break;
+      case TRIANGLE:
+        for (unsigned i = 0; i < n; ++i) {
+          const float p = out[i];
+          const float inc = hz ? hz[i] * scale : increment;
+          const float s = (p < 0.25f || p >= 0.75f) ? -4.0f : 4.0f;
+          float f = p * 4.0f - 2.0f;
+          f = (f > 1.0f) ? 2.0f - f : ((f < -1.0f) ? -2.0f - f : f);
+          out[i] = f - s * k * inc;
+        }
+        break;
+    }
+  }
+
+  // add residuals for the jumps and corners passed going from phase a to
+  // phase b (not wrapped, so maybe beyond 0 or 1) at increment inc. b was
+  // reached time samples before sample i.
+  void cross(float a, float b, float inc, float time, unsigned i) {
+    // going backwards, a jump is the other way up; a change in slope per
+    // sample is the same either way
+    const float sign = inc < 0 ? -1.0f : 1.0f;
+    auto corner = [&](float at, float height, float kink) {
+      for (float x = at - 1.0f; x <= at + 1.0f; x += 1.0f)
+        if (inc > 0 ? (a < x && x <= b) : (b <= x && x < a))
+          edge(i, time + (b - x) / inc, height * sign,
+               kink * std::fabs(inc));
+    };
+    switch (type) {
+      default:
+      case SAW:
+        corner(0.0f, -2.0f, 0.0f);
+        break;
+      case PULSE:
+        corner(0.0f, -2.0f, 0.0f);
+        corner(width, 2.0f, 0.0f);
+        break;
+      case TRIANGLE:
+        corner(0.25f, 0.0f, 8.0f);
+        corner(0.75f, 0.0f, -8.0f);
+        break;
+    }
+  }
+
+  void edge(unsigned i, float time, float height, float kink) {
+    if (height != 0) blep->step(&correction[i], time, height);
+    if (kink != 0) blep->ramp(&correction[i], time, kink);
+  }
+};
+
+struct BlepSaw : BlepOscillator {
+  BlepSaw() : BlepOscillator(SAW) {}
+};
+
+struct BlepSquare : BlepOscillator {
+  BlepSquare() : BlepOscillator(PULSE) {}
+};
+
+struct BlepPulse : BlepOscillator {
+  BlepPulse(float width = 0.25f) : BlepOscillator(PULSE) {
+    this->width = width;
+  }
+};
+
+struct BlepTriangle : BlepOscillator {
+  BlepTriangle() : BlepOscillator(TRIANGLE) {}
+};
+
+// a slave oscillator whose cycle restarts whenever the master's does. set
+// the frequency of each; the master is not heard.
+//
+struct BlepHardSync {
+  BlepOscillator master, slave;
+  std::vector<float> buffer, reset;
+
+  BlepHardSync() { reserve(blockSize); }
+
+  void prepare() {
+    master.prepare();
+    slave.prepare();
+    reserve(blockSize);
+  }
+
+  void reserve(unsigned n) {
+    if (buffer.size() < n) {
+      buffer.resize(n);
+      reset.resize(n);
+    }
+  }
+
+  float operator()() {
+    float f, r;
+    master.render(&f, nullptr, nullptr, &r, 1);
+    slave.render(&f, nullptr, &r, nullptr, 1);
+    return f;
+  }
+
+  void process(float* out, unsigned n) {
+    reserve(n);
+    master.render(&buffer[0], nullptr, nullptr, &reset[0], n);
+    slave.render(out, nullptr, &reset[0], nullptr, n);
+  }
+};
+
+// sin and cos of half the angle of every frequency from 0 to Nyquist, for
+// designing biquads without calling sin and cos. half angles, because 1 - cos
+// and 1 + cos (which lowpass and highpass need) are then 2 sin^2 and 2 cos^2,
+// and stay accurate for low and high frequencies. linear interpolation
+// between entries is within 1e-7.
+//
+struct BiquadTable {
+  static const unsigned size = 4096;
+  float sine[size + 2], cosine[size + 2];
+
+  BiquadTable() {
+    for (unsigned i = 0; i < size + 2; ++i) {
+      sine[i] = sin(M_PI / 2 * i / size);
+      cosine[i] = cos(M_PI / 2 * i / size);
+    }
+  }
+
+  static const BiquadTable& table() {
+    static const BiquadTable t;
+    return t;
+  }
+
+  // f0 in Hz; the index of Nyquist is size
+  void lookup(float f0, float& sh, float& ch) const {
+    float x = f0 / sampleRate * 2 * size;
+    if (x < 0) x = 0;
+    if (x > size) x = size;
+    const unsigned i = x;
+    const float t = x - i;
+    sh = sine[i] + (sine[i + 1] - sine[i]) * t;
+    ch = cosine[i] + (cosine[i + 1] - cosine[i]) * t;
+  }
+};
+
+// the five coefficients of a biquad, normalized so that a0 is 1, designed
+// with the Audio EQ Cookbook
+// http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
+//
+struct BiquadCoefficients {
+  enum Type { LPF, HPF, BPF, NOTCH, APF };
+
+  float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
 
   void normalize(float a0) {
-    b0 /= a0;
-    b1 /= a0;
-    b2 /= a0;
-    a1 /= a0;
-    a2 /= a0;
-    // print();
+    const float r = 1 / a0;
+    b0 *= r;
+    b1 *= r;
+    b2 *= r;
+    a1 *= r;
+    a2 *= r;
   }
 
   void print() {
@@ -277,206 +827,425 @@ class Biquad {
     printf("\n");
   }
 
-  void lpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    b0 = (1 - cos(w0)) / 2;
-    b1 = 1 - cos(w0);
-    b2 = (1 - cos(w0)) / 2;
-    float a0 = 1 + alpha;
-    a1 = -2 * cos(w0);
-    a2 = 1 - alpha;
+  // sin and cos of half of w0, then sin(w0), cos(w0) and alpha
+  struct Terms {
+    float sh, ch, s, c, alpha;
+    Terms(float f0, float Q) {
+      BiquadTable::table().lookup(f0, sh, ch);
+      s = 2 * sh * ch;
+      c = ch * ch - sh * sh;
+      alpha = s / (2 * Q);
+    }
+  };
+
+  void design(Type type, float f0, float Q) {
+    switch (type) {
+      case LPF:
+        lpf(f0, Q);
+        break;
+      case HPF:
+        hpf(f0, Q);
+        break;
+      case BPF:
+        bpf(f0, Q);
+        break;
+      case NOTCH:
+        notch(f0, Q);
+        break;
+      case APF:
+        apf(f0, Q);
+        break;
+    }
+  }
 
-    normalize(a0);
+  void lpf(float f0, float Q) {
+    Terms w(f0, Q);
+    b0 = w.sh * w.sh;  // (1 - cos(w0)) / 2
+    b1 = 2 * w.sh * w.sh;
+    b2 = w.sh * w.sh;
+    a1 = -2 * w.c;
+    a2 = 1 - w.alpha;
+    normalize(1 + w.alpha);
   }
 
   void hpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    b0 = (1 + cos(w0)) / 2;
-    b1 = -(1 + cos(w0));
-    b2 = (1 + cos(w0)) / 2;
-    float a0 = 1 + alpha;
-    a1 = -2 * cos(w0);
-    a2 = 1 - alpha;
-
-    normalize(a0);
+    Terms w(f0, Q);
+    b0 = w.ch * w.ch;  // (1 + cos(w0)) / 2
+    b1 = -2 * w.ch * w.ch;
+    b2 = w.ch * w.ch;
+    a1 = -2 * w.c;
+    a2 = 1 - w.alpha;
+    normalize(1 + w.alpha);
   }
 
   void bpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    b0 = Q * alpha;
+    Terms w(f0, Q);
+    b0 = w.s / 2;  // Q * alpha
     b1 = 0;
-    b2 = -Q * alpha;
-    float a0 = 1 + alpha;
-    a1 = -2 * cos(w0);
-    a2 = 1 - alpha;
-
-    normalize(a0);
+    b2 = -w.s / 2;
+    a1 = -2 * w.c;
+    a2 = 1 - w.alpha;
+    normalize(1 + w.alpha);
   }
 
   void notch(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
+    Terms w(f0, Q);
     b0 = 1;
-    b1 = -2 * cos(w0);
+    b1 = -2 * w.c;
     b2 = 1;
-    float a0 = 1 + alpha;
-    a1 = -2 * cos(w0);
-    a2 = 1 - alpha;
-
-    normalize(a0);
+    a1 = -2 * w.c;
+    a2 = 1 - w.alpha;
+    normalize(1 + w.alpha);
   }
 
   void apf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    b0 = 1 - alpha;
-    b1 = -2 * cos(w0);
-    b2 = 1 + alpha;
-    float a0 = 1 + alpha;
-    a1 = -2 * cos(w0);
-    a2 = 1 - alpha;
+    Terms w(f0, Q);
+    b0 = 1 - w.alpha;
+    b1 = -2 * w.c;
+    b2 = 1 + w.alpha;
+    a1 = -2 * w.c;
+    a2 = 1 - w.alpha;
+    normalize(1 + w.alpha);
+  }
+};
+
+// one biquad, in transposed direct form II: two state variables rather than
+// four, and the same output. for several in series, see BiquadCascade; for
+// several in parallel, BiquadBank (both in BiquadBank.h).
+class Biquad {
+  // the state of TDF-II
+  float z1 = 0, z2 = 0;
+
+  BiquadCoefficients c;
+
+  // the last design, for prepare(); not used once coefficients are given
+  BiquadCoefficients::Type type = BiquadCoefficients::APF;
+  float f0 = 1000.0f, Q = 0.5f;
+  bool designed = true;
+
+ public:
+  float operator()(float x0) {
+    float y0 = c.b0 * x0 + z1;
+    z1 = c.b1 * x0 - c.a1 * y0 + z2;
+    z2 = c.b2 * x0 - c.a2 * y0;
+    return y0;
+  }
+
+  // filter a block; in and out may be the same
+  void process(const float* in, float* out, unsigned n) {
+    const BiquadCoefficients k = c;
+    float s1 = z1, s2 = z2;
+    for (unsigned i = 0; i < n; ++i) {
+      const float x0 = in[i];
+      const float y0 = k.b0 * x0 + s1;
+      s1 = k.b1 * x0 - k.a1 * y0 + s2;
+      s2 = k.b2 * x0 - k.a2 * y0;
+      out[i] = y0;
+    }
+    z1 = s1;
+    z2 = s2;
+  }
+
+  Biquad() { apf(1000.0f, 0.5f); }
+
+  const BiquadCoefficients& coefficients() const { return c; }
+  void coefficients(const BiquadCoefficients& c) {
+    this->c = c;
+    designed = false;
+  }
+
+  void print() { c.print(); }
 
-    normalize(a0);
+  void design(BiquadCoefficients::Type type, float f0, float Q) {
+    this->type = type;
+    this->f0 = f0;
+    this->Q = Q;
+    designed = true;
+    c.design(type, f0, Q);
+  }
+  void lpf(float f0, float Q) { design(BiquadCoefficients::LPF, f0, Q); }
+  void hpf(float f0, float Q) { design(BiquadCoefficients::HPF, f0, Q); }
+  void bpf(float f0, float Q) { design(BiquadCoefficients::BPF, f0, Q); }
+  void notch(float f0, float Q) { design(BiquadCoefficients::NOTCH, f0, Q); }
+  void apf(float f0, float Q) { design(BiquadCoefficients::APF, f0, Q); }
+
+  void prepare() {
+    if (designed) c.design(type, f0, Q);
   }
 };
 
-// actually an ADR
+// attack, decay, sustain and release. gate(true) starts the attack and the
+// envelope holds at the sustain level until gate(false) starts the release.
+// trigger() plays attack, decay and release without waiting for a gate, and
+// with loop, a spent envelope triggers itself again.
+//
+// each stage is a segment from the level it starts at to the next level, in
+// a whole number of samples: a straight line, or with curve > 0, an
+// exponential (curve is how many time constants fit in the segment; a change
+// takes effect at the next stage). any sample of a segment is in closed
+// form, so process() fills a block with no per-sample checks, and active()
+// says when a voice can skip its work.
+//
 struct ADSR {
-  float a, d, s, r;
-  Line attack, decay, release;
-  int state;
+  enum Stage { ATTACK, DECAY, SUSTAIN, RELEASE, IDLE };
+
+  float a, d, s, r;  // milliseconds, milliseconds, level, milliseconds
+  float curve = 0;   // 0 is linear
   bool loop = false;
 
-  ADSR() { set(50.0f, 100.0f, 0.7f, 300.0f); }
+  Stage stage = IDLE;
+  bool gated = false;
+  float value = 0;  // the last value out
 
-  void reset() {
-    state = 0;
-    attack.set(0.0f, 1.0f, a);  // value, target, milliseconds
-    decay.set(1.0f, s, d);
-    release.set(s, 0.0f, r);
-  }
+  // the segment that is playing, and for a curve, the size of its
+  // exponential and how much that decays per sample
+  float from = 0, to = 0, scale = 0, k = 1;
+  unsigned length = 1, position = 0;
+
+  ADSR() { set(50.0f, 100.0f, 0.7f, 300.0f); }
 
   void set(float a, float d, float s, float r) {
     this->a = a;
     this->d = d;
     this->s = s;
     this->r = r;
-    reset();
   }
 
+  void gate(bool on) {
+    if (on) {
+      gated = true;
+      begin(ATTACK);
+    } else if (gated) {
+      gated = false;
+      if (stage != IDLE) begin(RELEASE);
+    }
+  }
+
+  void trigger() {
+    gated = false;
+    begin(ATTACK);
+  }
+
+  bool active() const { return stage != IDLE; }
+
   float operator()() { return nextValue(); }
   float nextValue() {
-    switch (state) {
-      case 0:
-        if (attack.done()) state = 1;
+    float v;
+    if (stage != IDLE && stage != SUSTAIN && position + 1 < length) {
+      // not the last sample of a segment
+      segment(&v, 1);
+      position++;
+      return value = v;
+    }
+    process(&v, 1);
+    return v;
+  }
+
+  void process(float* out, unsigned n) {
+    unsigned i = 0;
+    while (i < n) {
+      if (stage == IDLE && loop) trigger();
+      if (stage == IDLE || stage == SUSTAIN) {
+        value = stage == IDLE ? 0.0f : s;
+        for (; i < n; ++i) out[i] = value;
+        return;
+      }
+
+      const unsigned m = length - position < n - i ? length - position : n - i;
+      segment(out + i, m);
+      position += m;
+      i += m;
+      value = out[i - 1];
+      if (position == length) next();
+    }
+  }
+
+ private:
+  // m samples of the segment, from position on
+  void segment(float* out, unsigned m) {
+    const float x = float(position) / length;
+    if (curve <= 0) {
+      const float step = (to - from) / length;
+      const float start = from + (to - from) * x;
+      for (unsigned i = 0; i < m; ++i) out[i] = start + i * step;
+    } else {
+      // from + (to - from) (1 - e^(-curve x)) / (1 - e^(-curve))
+      float g = expf(-curve * x);
+      for (unsigned i = 0; i < m; ++i, g *= k) out[i] = from + scale * (1 - g);
+    }
+  }
+
+  void begin(Stage next) {
+    stage = next;
+    from = value;
+    position = 0;
+    switch (stage) {
+      case ATTACK:
+        to = 1;
+        length = samples(a);
         break;
-      case 1:
-        if (decay.done()) state = 2;
+      case DECAY:
+        to = s;
+        length = samples(d);
         break;
-      case 2:
-        if (release.done()) state = 3;
+      case RELEASE:
+        to = 0;
+        length = samples(r);
         break;
       default:
-        if (loop) reset();
-        break;
+        return;
     }
-    switch (state) {
-      case 0:
-        // cout << "a:";
-        return attack.nextValue();
-      case 1:
-        // cout << "d:";
-        return decay.nextValue();
-      case 2:
-        // cout << "r:";
-        return release.nextValue();
+    if (curve > 0) {
+      scale = (to - from) / (1 - expf(-curve));
+      k = expf(-curve / length);
+    }
+  }
+
+  // at the end of a segment, land on its level and start the next stage
+  void next() {
+    value = to;
+    switch (stage) {
+      case ATTACK:
+        begin(DECAY);
+        break;
+      case DECAY:
+        begin(gated ? SUSTAIN : RELEASE);
+        break;
       default:
-        // we are spent; call trigger to start again
-        // cout << "e:";
-        return 0.0f;
+        begin(IDLE);
+        break;
     }
   }
+
+  // at least one, so that every segment ends
+  static unsigned samples(float milliseconds) {
+    const float n = milliseconds / 1000.0f * sampleRate + 0.5f;
+    return n < 1 ? 1 : unsigned(n);
+  }
 };
 
+// a biquad whose frequency and Q glide, for filters that are modulated.
+// rather than gliding each coefficient (which can pass through unstable
+// filters), the frequency (in octaves) and Q (in log) are smoothed, and the
+// coefficients are designed from them once every interval samples. between
+// designs, the coefficients ramp linearly, so nothing zippers.
+//
 class BiquadWithLines {
-  // Audio EQ Cookbook
-  // http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
+  // the state of TDF-II
+  float z1 = 0, z2 = 0;
 
-  // x[n-1], x[n-2], y[n-1], y[n-2]
-  float x1, x2, y1, y2;
+  // the coefficients now, where they ramp to, and how much per sample
+  BiquadCoefficients c, target, step;
+  void (BiquadCoefficients::*design)(float, float) = &BiquadCoefficients::lpf;
 
-  // filter coefficients
-  Line b0, b1, b2, a1, a2;
+  // log2 of the frequency and log of Q: now, and where they glide to
+  float octave = 0, octaveTarget = 0, logQ = 0, logQTarget = 0;
+  bool jump = true, changed = false;
 
- public:
-  float operator()(float x0) {
-    // Direct Form 1, normalized...
-    float y0 = b0() * x0 + b1() * x1 + b2() * x2 - a1() * y1 - a2() * y2;
-    y2 = y1;
-    y1 = y0;
-    x2 = x1;
-    x1 = x0;
-    return y0;
-  }
+  float milliseconds = 30;
+  unsigned period = 32, remaining = 0;
 
+ public:
   BiquadWithLines() { lpf(10000.0f, 0.7f); }
 
-  void lpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    float a0 = 1 + alpha;
-    b0.set(((1 - cos(w0)) / 2) / a0);
-    b1.set((1 - cos(w0)) / a0);
-    b2.set(((1 - cos(w0)) / 2) / a0);
-    a1.set((-2 * cos(w0)) / a0);
-    a2.set((1 - alpha) / a0);
-  }
+  // how many samples between designs (16, 32 or 64 are good choices) and
+  // how long the glide takes (about 2/3 of the way in this time)
+  void interval(unsigned samples) { period = samples > 0 ? samples : 1; }
+  void time(float milliseconds) { this->milliseconds = milliseconds; }
 
-  void hpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    float a0 = 1 + alpha;
-    b0.set(((1 + cos(w0)) / 2) / a0);
-    b1.set((-(1 + cos(w0))) / a0);
-    b2.set(((1 + cos(w0)) / 2) / a0);
-    a1.set((-2 * cos(w0)) / a0);
-    a2.set((1 - alpha) / a0);
+  void lpf(float f0, float Q) { glide(&BiquadCoefficients::lpf, f0, Q); }
+  void hpf(float f0, float Q) { glide(&BiquadCoefficients::hpf, f0, Q); }
+  void bpf(float f0, float Q) { glide(&BiquadCoefficients::bpf, f0, Q); }
+  void notch(float f0, float Q) { glide(&BiquadCoefficients::notch, f0, Q); }
+  void apf(float f0, float Q) { glide(&BiquadCoefficients::apf, f0, Q); }
+
+  // design again at the next interval
+  void prepare() { changed = true; }
+
+  float operator()(float x0) {
+    if (remaining == 0) update();
+    remaining--;
+    float y0 = c.b0 * x0 + z1;
+    z1 = (c.b1 * x0 + z2) - c.a1 * y0;
+    z2 = c.b2 * x0 - c.a2 * y0;
+    c.b0 += step.b0;
+    c.b1 += step.b1;
+    c.b2 += step.b2;
+    c.a1 += step.a1;
+    c.a2 += step.a2;
+    return y0;
   }
 
-  void bpf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    float a0 = 1 + alpha;
-    b0.set((Q * alpha) / a0);
-    b1.set((0) / a0);
-    b2.set((-Q * alpha) / a0);
-    a1.set((-2 * cos(w0)) / a0);
-    a2.set((1 - alpha) / a0);
+  // filter a block; in and out may be the same
+  void process(const float* in, float* out, unsigned n) {
+    while (n > 0) {
+      if (remaining == 0) update();
+      const unsigned m = n < remaining ? n : remaining;
+      BiquadCoefficients k = c;
+      const BiquadCoefficients d = step;
+      float s1 = z1, s2 = z2;
+      for (unsigned i = 0; i < m; ++i) {
+        const float x0 = in[i];
+        const float y0 = k.b0 * x0 + s1;
+        s1 = (k.b1 * x0 + s2) - k.a1 * y0;
+        s2 = k.b2 * x0 - k.a2 * y0;
+        out[i] = y0;
+        k.b0 += d.b0;
+        k.b1 += d.b1;
+        k.b2 += d.b2;
+        k.a1 += d.a1;
+        k.a2 += d.a2;
+      }
+      c = k;
+      z1 = s1;
+      z2 = s2;
+      remaining -= m;
+      in += m;
+      out += m;
+      n -= m;
+    }
   }
 
-  void notch(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    float a0 = 1 + alpha;
-    b0.set((1) / a0);
-    b1.set((-2 * cos(w0)) / a0);
-    b2.set((1) / a0);
-    a1.set((-2 * cos(w0)) / a0);
-    a2.set((1 - alpha) / a0);
+ private:
+  void glide(void (BiquadCoefficients::*type)(float, float), float f0,
+             float Q) {
+    design = type;
+    changed = true;
+    octaveTarget = log2f(f0);
+    logQTarget = logf(Q);
+    if (jump) {
+      jump = false;
+      octave = octaveTarget;
+      logQ = logQTarget;
+      (target.*design)(f0, Q);
+      c = target;
+      remaining = 0;
+      changed = false;
+    }
   }
 
-  void apf(float f0, float Q) {
-    float w0 = 2 * M_PI * f0 / sampleRate;
-    float alpha = sin(w0) / (2 * Q);
-    float a0 = 1 + alpha;
-    b0.set((1 - alpha) / a0);
-    b1.set((-2 * cos(w0)) / a0);
-    b2.set((1 + alpha) / a0);
-    a1.set((-2 * cos(w0)) / a0);
-    a2.set((1 - alpha) / a0);
+  // once per interval: glide the parameters, design the coefficients at the
+  // end of the next interval and ramp to them. once the glide is over, there
+  // is nothing to design, and the ramp is flat.
+  void update() {
+    c = target;  // land exactly on the last design
+    if (changed || octave != octaveTarget || logQ != logQTarget) {
+      const float k =
+          1 - expf(-1000.0f * period / (milliseconds * sampleRate + 1e-9f));
+      octave += (octaveTarget - octave) * k;
+      logQ += (logQTarget - logQ) * k;
+      if (fabsf(octaveTarget - octave) < 1e-4f) octave = octaveTarget;
+      if (fabsf(logQTarget - logQ) < 1e-4f) logQ = logQTarget;
+      (target.*design)(exp2f(octave), expf(logQ));
+      changed = false;
+    }
+    const float scale = 1.0f / period;
+    step.b0 = (target.b0 - c.b0) * scale;
+    step.b1 = (target.b1 - c.b1) * scale;
+    step.b2 = (target.b2 - c.b2) * scale;
+    step.a1 = (target.a1 - c.a1) * scale;
+    step.a2 = (target.a2 - c.a2) * scale;
+    remaining = period;
   }
 };
 
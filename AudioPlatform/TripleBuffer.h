@@ -0,0 +1,52 @@
+#ifndef __AP_TRIPLE_BUFFER__
+#define __AP_TRIPLE_BUFFER__
+
+#include <atomic>
+#include <vector>
+
+namespace ap {
+
+// hands whole frames of samples (e.g., a history for display) from one
+// thread to one other thread without locks. the writer always has a buffer
+// of its own to fill and the reader always gets the newest complete frame;
+// neither ever waits on the other. frames the reader never got around to
+// are simply replaced by newer ones.
+//
+// there are three buffers: the writer owns one (back), the reader owns one
+// (front), and the third (middle) is swapped atomically between them.
+//
+struct TripleBuffer {
+  std::vector<float> buffer[3];
+
+  // the index of the middle buffer, or'd with FRESH when the writer has
+  // published a frame that the reader has not yet taken
+  enum { INDEX = 3, FRESH = 4 };
+  std::atomic<unsigned> middle{1};
+  unsigned back = 0, front = 2;
+
+  // allocate; call this before either thread starts using the buffer
+  void setup(unsigned size) {
+    for (auto& b : buffer) b.assign(size, 0.0f);
+  }
+  unsigned size() const { return buffer[0].size(); }
+
+  // the writer's buffer; fill it, then publish()
+  float* write() { return &buffer[back][0]; }
+
+  // give the frame in the writer's buffer to the reader
+  void publish() {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+  }
+
+  // the newest complete frame; it stays valid (and unchanged) until the
+  // next call to read()
+  const float* read() {
+    if (middle.load(std::memory_order_relaxed) & FRESH)
+      front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+    return &buffer[front][0];
+  }
+};
+
+}  // namespace ap
+
+#endif
@@ -1,40 +1,106 @@
 #ifndef __AP_TYPES__
 #define __AP_TYPES__
 
+#include <cstddef>
+
 namespace ap {
 
-// why not inherit from vector<float>?
+struct Arena;
+
+// why not inherit from vector<float>? this is a plain block of floats that
+// starts on a 64-byte (cache line) boundary, and it can use storage that
+// belongs to something else (an Arena, a shared table). copies are deep;
+// moves take the storage.
 struct Array {
   float* data = nullptr;
   unsigned size = 0;
+  bool borrowed = false;  // the storage belongs to something else
 
-  // what vector does
-  /*
-  Array(const Array& other) {
-    resize(other.size);
-    for (unsigned i = 0; i < size; i++) data[i] = other.data[i];
-  }
-  */
-
+  Array() = default;
+  Array(const Array& other);
+  Array(Array&& other) noexcept;
+  Array& operator=(const Array& other);
+  Array& operator=(Array&& other) noexcept;
   virtual ~Array();
 
   float& operator[](unsigned index);
   float operator[](const float index) const;
 
+  // resize to n zeros, dropping the contents
   void resize(unsigned n);
   void zeros(unsigned n);
 
+  // as above, with storage from the arena (or the heap, if it is full). the
+  // storage lasts until the arena is reset or destroyed.
+  void resize(unsigned n, Arena& arena);
+
+  // use n floats that belong to something else, which must outlive them
+  void borrow(float* data, unsigned n);
+
   float get(const float index) const;
 
   void add(const float index, const float value);
 
-  // deep-copy copy constructor
-  // Array(const Array& other);
-  // also do assignment
+ private:
+  void release();
+};
+
+// one aligned block, handed out in pieces to many Arrays that are set up
+// together (grains, wavetables) and freed together, all at once. the arena
+// never grows, so once it is set up, nothing allocates.
+struct Arena {
+  float* data = nullptr;
+  size_t capacity = 0, used = 0;  // in floats
+
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  // allocate room for this many floats, freeing what was there
+  void setup(size_t capacity);
+
+  // n zeros, on a 64-byte boundary, or nullptr if there is no room
+  float* allocate(size_t n);
+
+  // take back every allocation; the Arrays that had them must not be used
+  void reset() { used = 0; }
+
+  // the room an allocation of n floats takes
+  static size_t footprint(size_t n) { return (n + 15) & ~size_t(15); }
 };
 
 typedef Array FloatArrayWithLinearInterpolation;
 
+// several channels of samples, decoded once. the channels are stored one
+// after another (planar), each starting on a 64-byte (cache line) boundary,
+// and each followed by a copy of its first sample, so that interpolation
+// with looping needs no branch.
+struct SampleBuffer {
+  float* data = nullptr;
+  unsigned channels = 0, frames = 0;
+  unsigned stride = 0;  // floats from the start of one channel to the next
+  float sampleRate = 0;
+
+  SampleBuffer() = default;
+  SampleBuffer(const SampleBuffer&) = delete;
+  SampleBuffer& operator=(const SampleBuffer&) = delete;
+  ~SampleBuffer();
+
+  float* operator[](unsigned c) { return data + c * stride; }
+  const float* operator[](unsigned c) const { return data + c * stride; }
+
+  // allocate silence
+  void resize(unsigned channels, unsigned frames);
+
+  // decode every channel of a .wav file. returns false if it can't be read.
+  bool load(const char* filePath);
+
+  // copy the first sample of each channel past the end; call this after
+  // writing to the channels directly
+  void guard();
+};
+
 }  // namespace ap
 
 #endif
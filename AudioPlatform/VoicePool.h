@@ -0,0 +1,169 @@
+#ifndef __AP_VOICE_POOL__
+#define __AP_VOICE_POOL__
+
+#include "AudioPlatform/Functions.h"
+#include "AudioPlatform/Globals.h"
+#include "AudioPlatform/MIDI.h"
+#include "AudioPlatform/Synths.h"
+
+#include <cassert>
+#include <vector>
+
+namespace ap {
+
+// a fixed number of voices, allocated up front, played by MIDI note messages.
+// a Voice is anything with these methods:
+//
+//   void noteOn(float note, float velocity);  // note is MIDI, velocity 0..1
+//   void noteOff();
+//   bool active();                            // false once it is silent
+//   void process(float* out, unsigned n);     // write the next n samples
+//   void prepare(unsigned n);                 // for the sampleRate now and
+//                                             // blocks of up to n samples
+//
+// voices that are not active are skipped, so an idle voice costs one call to
+// active() per block. each active voice renders a whole block at a time, so
+// the loops in its process() can be vectorized.
+//
+// when every voice is busy, a note on steals the oldest released voice, or
+// failing that, the oldest voice.
+//
+template <typename Voice, unsigned N>
+struct VoicePool {
+  Voice voice[N];
+  int note[N];               // the note a voice is holding, or -1
+  unsigned long started[N];  // when each voice was last started
+  unsigned long counter = 0;
+  std::vector<float> buffer;
+
+  VoicePool() {
+    for (unsigned v = 0; v < N; ++v) {
+      note[v] = -1;
+      started[v] = 0;
+    }
+  }
+
+  // allocate for blocks of up to n samples, and prepare the voices for the
+  // sampleRate now. nothing is allocated after this.
+  void setup(unsigned n = blockSize) {
+    buffer.resize(n);
+    for (unsigned v = 0; v < N; ++v) voice[v].prepare(n);
+  }
+
+  void noteOn(int n, float velocity) {
+    unsigned v = choose(n);
+    note[v] = n;
+    started[v] = ++counter;
+    voice[v].noteOn(n, velocity);
+  }
+
+  void noteOff(int n) {
+    for (unsigned v = 0; v < N; ++v)
+      if (note[v] == n) {
+        note[v] = -1;
+        voice[v].noteOff();
+      }
+  }
+
+  void allNotesOff() {
+    for (unsigned v = 0; v < N; ++v)
+      if (note[v] >= 0) {
+        note[v] = -1;
+        voice[v].noteOff();
+      }
+  }
+
+  // handle a message from ap::MIDI; anything but note on, note off and all
+  // notes off is ignored
+  void midi(const std::vector<unsigned char>& message) {
+    if (message.size()) midi(&message[0], message.size());
+  }
+  void midi(const MIDI::Event& event) { midi(event.data, event.size); }
+  void midi(const unsigned char* message, unsigned size) {
+    if (size < 3) return;
+    const unsigned char status = message[0] & 0xF0;
+    if (status == 0x90 && message[2] > 0)
+      noteOn(message[1], message[2] / 127.0f);
+    else if (status == 0x80 || status == 0x90)
+      noteOff(message[1]);
+    else if (status == 0xB0 && message[1] == 123)
+      allNotesOff();
+  }
+
+  // write the sum of the active voices into out
+  void process(float* out, unsigned n) {
+    for (unsigned i = 0; i < n; ++i) out[i] = 0;
+    float* b = &buffer[0];
+    for (unsigned v = 0; v < N; ++v) {
+      if (!voice[v].active()) continue;
+      voice[v].process(b, n);
+      for (unsigned i = 0; i < n; ++i) out[i] += b[i];
+    }
+  }
+
+  unsigned active() {
+    unsigned count = 0;
+    for (unsigned v = 0; v < N; ++v)
+      if (voice[v].active()) count++;
+    return count;
+  }
+
+  // pick a voice for note n: the one already playing n, an idle one, the
+  // oldest released one or the oldest one, in that order
+  unsigned choose(int n) {
+    for (unsigned v = 0; v < N; ++v)
+      if (note[v] == n) return v;
+    for (unsigned v = 0; v < N; ++v)
+      if (!voice[v].active()) return v;
+    unsigned oldest = N, oldestHeld = 0;
+    for (unsigned v = 0; v < N; ++v) {
+      if (note[v] < 0) {
+        if (oldest == N || started[v] < started[oldest]) oldest = v;
+      } else if (started[v] < started[oldestHeld])
+        oldestHeld = v;
+    }
+    return oldest == N ? oldestHeld : oldest;
+  }
+};
+
+// a simple subtractive voice: a Saw through a low-pass Biquad, shaped by an
+// ADSR that is gated by the note. it is idle once the release is over.
+//
+struct SawVoice {
+  Saw saw;
+  Biquad filter;
+  ADSR envelope;
+  float gain = 0;
+  std::vector<float> level;
+
+  SawVoice() { filter.lpf(4000.0f, 0.7f); }
+
+  void noteOn(float note, float velocity) {
+    saw.frequency(mtof(note));
+    gain = velocity;
+    envelope.gate(true);
+  }
+
+  void noteOff() { envelope.gate(false); }
+
+  bool active() { return envelope.active(); }
+
+  void prepare(unsigned n) {
+    saw.prepare();
+    filter.prepare();
+    level.resize(n);
+  }
+
+  // n is no more than prepare() was given
+  void process(float* out, unsigned n) {
+    assert(n <= level.size());
+    saw.process(out, n);
+    filter.process(out, out, n);
+    envelope.process(&level[0], n);
+    for (unsigned i = 0; i < n; ++i) out[i] *= level[i] * gain;
+  }
+};
+
+}  // namespace ap
+
+#endif
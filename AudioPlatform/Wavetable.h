@@ -0,0 +1,84 @@
+#ifndef __AP_WAVETABLE__
+#define __AP_WAVETABLE__
+
+#include <vector>
+#include "AudioPlatform/Synths.h"
+
+namespace ap {
+
+// a single-cycle waveform as a set of band-limited tables, one per octave.
+// level k keeps the first (harmonics >> k) harmonics, so it plays without
+// aliasing up to a frequency of sampleRate / 2 / (harmonics >> k). each
+// table is oversampled (size is 4 * harmonics) so that linear interpolation
+// stays accurate.
+//
+// tables are built once, through ap::FFT. the presets are built the first
+// time they are asked for and shared by every oscillator that uses them.
+//
+struct Mipmap {
+  static const unsigned harmonics = 1024;
+  static const unsigned size = 4 * harmonics;
+  static const unsigned levels = 11;  // 1024, 512, ... 1 harmonics
+
+  // each table has size + 2 samples; the last two are copies of the first
+  // two, so that lookup needs no wrapping, even when a phase is exactly 1
+  std::vector<float> level[levels];
+
+  // from the amplitudes of the sine (b) and cosine (a) harmonics; b[0] is
+  // the fundamental. missing harmonics are 0.
+  void harmonic(const std::vector<float>& b,
+                const std::vector<float>& a = std::vector<float>());
+
+  // from one cycle of a waveform of any length; it is resampled to size by
+  // linear interpolation before the FFT
+  void wave(const float* data, unsigned n);
+
+  static const Mipmap& saw();
+  static const Mipmap& square();
+  static const Mipmap& triangle();
+  static const Mipmap& sine();
+
+  // from the spectrum of one cycle of length size
+  void build(const std::vector<float>& real, const std::vector<float>& imag);
+};
+
+// a table-lookup oscillator, like Table, that reads from a Mipmap. the level
+// is chosen from the frequency: the highest harmonic of the lower level is
+// always below Nyquist. over the bottom quarter of each octave, the level
+// with twice as many harmonics is crossfaded in, so the timbre does not jump
+// at octave boundaries; the only aliases this lets through fold down to
+// above 0.8 of Nyquist, and fade out as they do.
+//
+struct Wavetable : Phasor {
+  const Mipmap* mipmap = &Mipmap::saw();
+
+  Wavetable() {}
+  Wavetable(const Mipmap& m) : mipmap(&m) {}
+
+  virtual float operator()() { return nextValue(); }
+  virtual float nextValue() {
+    float out = step();
+    lookup(&out, hz, 1);
+    return out;
+  }
+
+  void process(float* out, unsigned n) {
+    Phasor::process(out, n);
+    lookup(out, hz, n);
+  }
+
+  void process(float* out, const float* hz, unsigned n) {
+    Phasor::process(out, hz, n);
+    lookup(out, hz, n);
+  }
+
+  // replace a block of phases with table values, at one frequency
+  void lookup(float* out, float hz, unsigned n) const;
+
+  // as above, with a frequency for each sample
+  void lookup(float* out, const float* hz, unsigned n) const;
+};
+
+}  // namespace ap
+
+#endif
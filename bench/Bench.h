@@ -0,0 +1,46 @@
+#ifndef __AP_BENCH__
+#define __AP_BENCH__
+
+#include <chrono>
+#include <cstdio>
+
+// a tiny benchmark harness. each measurement prints one tab-separated line:
+//
+//   name    size    samples_per_second
+//
+// where size is whatever parameter the benchmark varies (block size, FFT
+// size, partial count, ...). bench/run builds everything with optimization
+// and prefixes each line with the commit, so results can be collected and
+// compared across commits.
+
+namespace bench {
+
+// results are added here so the compiler can't throw the work away
+static volatile float sink = 0;
+
+// how long to keep calling each benchmark
+static const double minimumSeconds = 0.25;
+
+// call f() until at least minimumSeconds have passed. each call processes
+// samplesPerCall samples. returns samples per second.
+template <typename F>
+double measure(const char* name, unsigned size, double samplesPerCall, F f) {
+  using namespace std::chrono;
+  f();  // warm up
+  unsigned long calls = 0;
+  double elapsed = 0;
+  auto begin = steady_clock::now();
+  do {
+    f();
+    calls++;
+    elapsed = duration<double>(steady_clock::now() - begin).count();
+  } while (elapsed < minimumSeconds);
+  double rate = calls * samplesPerCall / elapsed;
+  printf("%s\t%u\t%.0f\n", name, size, rate);
+  fflush(stdout);
+  return rate;
+}
+
+}  // namespace bench
+
+#endif
@@ -0,0 +1,76 @@
+#include <string>
+#include <vector>
+#include "AudioPlatform/FFT.h"
+#include "AudioPlatform/Synths.h"
+#include "bench/Bench.h"
+
+// samples per second through FFT::forward, FFT::reverse (alone and with
+// each polar conversion) and STFT at several sizes. for the FFT, a call of
+// size N counts as N samples.
+
+using namespace ap;
+using bench::measure;
+using bench::sink;
+
+int main() {
+  for (unsigned size : {256, 1024, 4096, 16384}) {
+    FFT fft;
+    fft.setup(size);
+    std::vector<float> data(size);
+    Noise noise;
+    for (auto& f : data) f = noise();
+
+    // the FFT alone, with the spectrum left as (real, imag)
+    measure("FFT::forward", size, size, [&]() {
+      fft.forward(&data[0]);
+      sink = fft.real[1];
+    });
+    measure("FFT::reverse", size, size, [&]() {
+      fft.reverse(&data[0]);
+      sink = data[1];
+    });
+
+    // with a conversion to (magnitude, phase) and back
+    const char* name[] = {"EXACT", "FAST"};
+    for (auto conversion : {FFT::EXACT, FFT::FAST}) {
+      fft.conversion = conversion;
+      std::string suffix = std::string("/") + name[conversion];
+      measure(("FFT::forward+polar" + suffix).c_str(), size, size, [&]() {
+        fft.forward(&data[0]);
+        sink = fft.magnitude[1];
+      });
+      measure(("FFT::polar+reverse" + suffix).c_str(), size, size, [&]() {
+        fft.magnitude[1] = 0;
+        fft.reverse(&data[0]);
+        sink = data[1];
+      });
+    }
+  }
+
+  for (unsigned size : {512, 1024, 4096}) {
+    const unsigned n = blockSize;
+    std::vector<float> block(n);
+    Noise noise;
+    for (auto& f : block) f = noise();
+
+    STFT stft;
+    stft.setup(size);
+    measure("STFT/sample", size, n, [&]() {
+      float f = 0;
+      for (unsigned i = 0; i < n; ++i) {
+        stft(block[i]);
+        f += stft();
+      }
+      sink = f;
+    });
+
+    for (unsigned overlap : {2, 4, 8}) {
+      stft.setup(size, overlap);
+      std::string name = "STFT::process/x" + std::to_string(overlap);
+      measure(name.c_str(), size, n, [&]() {
+        stft.process(&block[0], &block[0], n, []() {});
+        sink = block[1];
+      });
+    }
+  }
+}
@@ -0,0 +1,46 @@
+#include <vector>
+#include "AudioPlatform/OscillatorBank.h"
+#include "AudioPlatform/Synths.h"
+#include "bench/Bench.h"
+
+// compare OscillatorBank to the vector<Sine> and vector<Line> loop that
+// example/resynthesis.cpp used to run. the size is the number of partials.
+
+using namespace ap;
+using bench::measure;
+using bench::sink;
+
+int main() {
+  const unsigned n = blockSize;
+  std::vector<float> block(n);
+  float* out = &block[0];
+
+  for (unsigned partials : {1, 4, 16, 64, 256}) {
+    // the old way: one Sine, and a Line for each of frequency and gain, per
+    // partial, called one sample at a time
+    std::vector<Sine> sine(partials);
+    std::vector<Line> gain(partials), freq(partials);
+    for (unsigned k = 0; k < partials; ++k) {
+      freq[k].set(110.0f * (k + 1), 15);
+      gain[k].set(1.0f / (k + 1), 15);
+    }
+    measure("Sine+Line", partials, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) {
+        for (unsigned k = 0; k < partials; ++k) sine[k].frequency(freq[k]());
+        float f = 0;
+        for (unsigned k = 0; k < partials; ++k) f += sine[k]() * gain[k]();
+        out[i] = f;
+      }
+      sink = out[n - 1];
+    });
+
+    OscillatorBank bank;
+    bank.setup(partials);
+    for (unsigned k = 0; k < partials; ++k)
+      bank.set(k, 110.0f * (k + 1), 1.0f / (k + 1));
+    measure("OscillatorBank", partials, n, [&]() {
+      bank.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+}
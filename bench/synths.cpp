@@ -0,0 +1,314 @@
+#include <vector>
+#include "AudioPlatform/BiquadBank.h"
+#include "AudioPlatform/FastMath.h"
+#include "AudioPlatform/Functions.h"
+#include "AudioPlatform/Noise.h"
+#include "AudioPlatform/Synths.h"
+#include "AudioPlatform/Wavetable.h"
+#include "bench/Bench.h"
+
+// samples per second for each of the primitives in Synths.h, one sample at a
+// time and (where there is one) through the block interface
+
+using namespace ap;
+using bench::measure;
+using bench::sink;
+
+int main() {
+  const unsigned n = blockSize;
+  std::vector<float> block(n);
+  float* out = &block[0];
+
+  {
+    Phasor phasor;
+    phasor.frequency(440);
+    measure("Phasor", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = phasor();
+      sink = out[n - 1];
+    });
+    measure("Phasor::process", n, n, [&]() {
+      phasor.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    Sine sine;
+    float index = 0;
+    const float step = sine.size * 0.01f;
+    measure("Table::get", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) {
+        out[i] = sine.get(index);
+        index += step;
+        if (index >= sine.size) index -= sine.size;
+      }
+      sink = out[n - 1];
+    });
+
+    sine.frequency(440);
+    measure("Sine", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = sine();
+      sink = out[n - 1];
+    });
+    measure("Sine::process", n, n, [&]() {
+      sine.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    // the naive saw against the band-limited one; 3000 Hz is in a crossfade
+    Saw saw;
+    saw.frequency(440);
+    measure("Saw::process", n, n, [&]() {
+      saw.process(out, n);
+      sink = out[n - 1];
+    });
+
+    Wavetable wavetable(Mipmap::saw());
+    wavetable.frequency(440);
+    measure("Wavetable", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = wavetable();
+      sink = out[n - 1];
+    });
+    measure("Wavetable::process", n, n, [&]() {
+      wavetable.process(out, n);
+      sink = out[n - 1];
+    });
+    wavetable.frequency(3000);
+    measure("Wavetable::process/crossfade", n, n, [&]() {
+      wavetable.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    BlepSaw saw;
+    saw.frequency(440);
+    measure("BlepSaw", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = saw();
+      sink = out[n - 1];
+    });
+    measure("BlepSaw::process", n, n, [&]() {
+      saw.process(out, n);
+      sink = out[n - 1];
+    });
+
+    BlepTriangle triangle;
+    triangle.frequency(440);
+    measure("BlepTriangle::process", n, n, [&]() {
+      triangle.process(out, n);
+      sink = out[n - 1];
+    });
+
+    BlepHardSync sync;
+    sync.master.frequency(110);
+    sync.slave.frequency(110 * 2.37f);
+    measure("BlepHardSync::process", n, n, [&]() {
+      sync.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    // the table of random numbers against generating them
+    Noise noise;
+    noise.frequency(1);
+    measure("Noise::process", n, n, [&]() {
+      noise.process(out, n);
+      sink = out[n - 1];
+    });
+
+    WhiteNoise white;
+    measure("WhiteNoise", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = white();
+      sink = out[n - 1];
+    });
+    measure("WhiteNoise::process", n, n, [&]() {
+      white.process(out, n);
+      sink = out[n - 1];
+    });
+
+    PinkNoise pink;
+    measure("PinkNoise::process", n, n, [&]() {
+      pink.process(out, n);
+      sink = out[n - 1];
+    });
+
+    BrownNoise brown;
+    measure("BrownNoise::process", n, n, [&]() {
+      brown.process(out, n);
+      sink = out[n - 1];
+    });
+
+    measure("uniform", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = uniform(-1.0f, 1.0f);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    // conversions, one at a time (as libm did them before) and by the array
+    std::vector<float> in(n);
+    for (unsigned i = 0; i < n; ++i) in[i] = 127.0f * i / n;
+    measure("powf", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i)
+        out[i] = 8.175799f * powf(2.0f, in[i] / 12.0f);
+      sink = out[n - 1];
+    });
+    measure("mtof", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = mtof(in[i]);
+      sink = out[n - 1];
+    });
+    measure("mtof[]", n, n, [&]() {
+      mtof(&in[0], out, n);
+      sink = out[n - 1];
+    });
+    measure("fastTanh[]", n, n, [&]() {
+      fastTanh(&in[0], out, n);
+      sink = out[n - 1];
+    });
+    measure("fastTanh[]/coarse", n, n, [&]() {
+      fastTanh(&in[0], out, n, COARSE);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    // designs, one filter at a time and a bank's worth at once
+    std::vector<float> f0(n), Q(n, 0.7f), b0(n), b1(n), b2(n), a1(n), a2(n);
+    for (unsigned i = 0; i < n; ++i) f0[i] = mtof(30 + 90.0f * i / n);
+    BiquadCoefficients c;
+    measure("BiquadCoefficients::lpf", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) {
+        c.lpf(f0[i], Q[i]);
+        b0[i] = c.b0;
+      }
+      sink = b0[n - 1];
+    });
+    measure("design", n, n, [&]() {
+      design(BiquadCoefficients::LPF, &f0[0], &Q[0], n, &b0[0], &b1[0],
+             &b2[0], &a1[0], &a2[0]);
+      sink = b0[n - 1];
+    });
+  }
+
+  {
+    Saw saw;
+    saw.frequency(110);
+    Biquad biquad;
+    biquad.lpf(1000, 0.7);
+    measure("Biquad", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = biquad(saw());
+      sink = out[n - 1];
+    });
+
+    saw.process(out, n);
+    measure("Biquad::process", n, n, [&]() {
+      biquad.process(out, out, n);
+      sink = out[n - 1];
+    });
+
+    // six in series: nested calls against a cascade
+    Biquad chain[6];
+    BiquadCascade cascade;
+    cascade.setup(6);
+    for (unsigned k = 0; k < 6; ++k) {
+      chain[k].apf(200 * (k + 1), 0.7);
+      cascade.set(k, chain[k].coefficients());
+    }
+    measure("Biquad/6", 6, n, [&]() {
+      for (unsigned i = 0; i < n; ++i)
+        out[i] = chain[0](chain[1](chain[2](chain[3](chain[4](chain[5](
+            out[i]))))));
+      sink = out[n - 1];
+    });
+    measure("BiquadCascade::process", 6, n, [&]() {
+      cascade.process(out, out, n);
+      sink = out[n - 1];
+    });
+
+    // three in parallel, as in example/formant-synth.cpp
+    std::vector<float> in(n);
+    saw.process(&in[0], n);
+    BiquadWithLines formant[3];
+    BiquadBank bank;
+    bank.setup(3);
+    for (unsigned k = 0; k < 3; ++k) {
+      BiquadCoefficients c;
+      c.bpf(500 * (k + 1), 3);
+      formant[k].bpf(500 * (k + 1), 3);
+      bank.set(k, c);
+    }
+    measure("BiquadWithLines/3", 3, n, [&]() {
+      for (unsigned i = 0; i < n; ++i)
+        out[i] = formant[0](in[i]) + formant[1](in[i]) + formant[2](in[i]);
+      sink = out[n - 1];
+    });
+    measure("BiquadBank::process", 3, n, [&]() {
+      bank.process(&in[0], out, n);
+      sink = out[n - 1];
+    });
+
+    BiquadWithLines lines;
+    lines.lpf(1000, 0.7);
+    measure("BiquadWithLines", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = lines(in[i]);
+      sink = out[n - 1];
+    });
+
+    // swept a little every block, as a slider or LFO would
+    float sweep = 0;
+    measure("BiquadWithLines/sweep", n, n, [&]() {
+      lines.lpf(1000 + 500 * sinf(sweep += 0.01f), 0.7);
+      for (unsigned i = 0; i < n; ++i) out[i] = lines(in[i]);
+      sink = out[n - 1];
+    });
+    measure("BiquadWithLines::process", n, n, [&]() {
+      lines.lpf(1000 + 500 * sinf(sweep += 0.01f), 0.7);
+      lines.process(&in[0], out, n);
+      sink = out[n - 1];
+    });
+
+    OnePole onePole;
+    onePole.frequency(0.01);
+    measure("OnePole", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = onePole(saw());
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    ADSR adsr;
+    adsr.loop = true;
+    measure("ADSR", n, n, [&]() {
+      for (unsigned i = 0; i < n; ++i) out[i] = adsr();
+      sink = out[n - 1];
+    });
+    measure("ADSR::process", n, n, [&]() {
+      adsr.process(out, n);
+      sink = out[n - 1];
+    });
+    adsr.curve = 5;
+    measure("ADSR::process/curve", n, n, [&]() {
+      adsr.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+
+  {
+    // a line that is always moving
+    Line line;
+    float target = 1;
+    measure("Line", n, n, [&]() {
+      if (line.done()) line.set(target = -target, 100);
+      for (unsigned i = 0; i < n; ++i) out[i] = line();
+      sink = out[n - 1];
+    });
+    measure("Line::process", n, n, [&]() {
+      if (line.done()) line.set(target = -target, 100);
+      line.process(out, n);
+      sink = out[n - 1];
+    });
+  }
+}
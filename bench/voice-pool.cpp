@@ -0,0 +1,45 @@
+#include <cstdio>
+#include <vector>
+#include "AudioPlatform/VoicePool.h"
+#include "bench/Bench.h"
+
+// render a VoicePool of SawVoice with every voice sounding, and with only a
+// few sounding (the rest idle and skipped). the size is the number of voices
+// sounding; samples are voice-samples, so dividing by 44100 gives the number
+// of voices one core can run in real time. that is also printed to stderr.
+
+using namespace ap;
+using bench::measure;
+using bench::sink;
+
+template <unsigned N>
+void run() {
+  const unsigned n = blockSize;
+  std::vector<float> block(n);
+  static VoicePool<SawVoice, N> pool;
+  pool.setup(n);
+
+  for (unsigned voices : {N / 8, N}) {
+    // idle envelopes, long enough that nothing finishes while we measure
+    for (auto& v : pool.voice) {
+      v.envelope = ADSR();
+      v.envelope.set(10.0f, 1e7f, 0.7f, 10.0f);
+    }
+    for (unsigned k = 0; k < voices; ++k)
+      pool.voice[k].noteOn(36 + k % 64, 0.5f);
+
+    double rate = measure(N == voices ? "VoicePool/all" : "VoicePool/some",
+                          voices, double(n) * voices, [&]() {
+                            pool.process(&block[0], n);
+                            sink = block[n - 1];
+                          });
+    fprintf(stderr, "%u of %u voices: %.0f voices per core at 44.1 kHz\n",
+            voices, N, rate / 44100);
+  }
+}
+
+int main() {
+  run<64>();
+  run<128>();
+  run<256>();
+}
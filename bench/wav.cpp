@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "AudioPlatform/MappedWav.h"
+#include "AudioPlatform/Synths.h"
+#include "AudioPlatform/Wav.h"
+#include "bench/Bench.h"
+
+// samples per second through the dr_wav read paths, for a few sample
+// formats. the format is appended to each name and its bits per sample is
+// the size. each format is written to a temporary file first.
+
+using namespace ap;
+using bench::measure;
+using bench::sink;
+
+const char* path = "bench-wav.tmp.wav";
+const unsigned frameCount = 10 * 44100;
+
+void write(drwav_uint32 format, drwav_uint32 bitsPerSample) {
+  drwav_data_format f;
+  f.channels = 2;
+  f.container = drwav_container_riff;
+  f.format = format;
+  f.sampleRate = 44100;
+  f.bitsPerSample = bitsPerSample;
+  drwav* pWav = drwav_open_file_write(path, &f);
+  if (pWav == nullptr) die("failed to open %s", path);
+
+  // a stereo saw, in whatever format we were asked for
+  std::vector<unsigned char> frames(frameCount * 2 * bitsPerSample / 8);
+  Saw saw;
+  saw.frequency(220);
+  for (unsigned i = 0; i < frameCount * 2; ++i) {
+    float v = 0.5f * saw();
+    unsigned char* p = &frames[i * bitsPerSample / 8];
+    if (format == DR_WAVE_FORMAT_IEEE_FLOAT) {
+      *(float*)p = v;
+    } else {
+      int s = v * 2147483647.0f;
+      for (unsigned b = 0; b < bitsPerSample / 8; ++b)
+        p[b] = s >> (32 - bitsPerSample + 8 * b);
+    }
+  }
+  drwav_write(pWav, frameCount * 2, &frames[0]);
+  drwav_close(pWav);
+}
+
+void read(std::string format, unsigned bitsPerSample) {
+  const unsigned samples = frameCount * 2;
+
+  std::string name = "drwav_open_and_read_file_f32/" + format;
+  measure(name.c_str(), bitsPerSample, samples, [&]() {
+    unsigned channels, sampleRate;
+    drwav_uint64 count;
+    float* data =
+        drwav_open_and_read_file_f32(path, &channels, &sampleRate, &count);
+    sink = data[count - 1];
+    drwav_free(data);
+  });
+
+  std::vector<float> chunk(4096);
+  name = "drwav_read_f32/" + format;
+  measure(name.c_str(), bitsPerSample, samples, [&]() {
+    drwav* pWav = drwav_open_file(path);
+    while (drwav_read_f32(pWav, chunk.size(), &chunk[0]) > 0) sink = chunk[0];
+    drwav_close(pWav);
+  });
+
+  std::vector<drwav_int16> chunk16(4096);
+  name = "drwav_read_s16/" + format;
+  measure(name.c_str(), bitsPerSample, samples, [&]() {
+    drwav* pWav = drwav_open_file(path);
+    while (drwav_read_s16(pWav, chunk16.size(), &chunk16[0]) > 0)
+      sink = chunk16[0];
+    drwav_close(pWav);
+  });
+
+  // map the file and view it a block at a time. for float data nothing is
+  // converted, so this is just the cost of opening and paging in the file
+  name = "MappedWav::view/" + format;
+  measure(name.c_str(), bitsPerSample, samples, [&]() {
+    MappedWav wav;
+    wav.open(path);
+    for (unsigned long long f = 0; f + 512 <= wav.frames; f += 512)
+      sink = wav.view(f, 512)[0];
+  });
+}
+
+int main() {
+  write(DR_WAVE_FORMAT_PCM, 16);
+  read("pcm", 16);
+  write(DR_WAVE_FORMAT_PCM, 24);
+  read("pcm", 24);
+  write(DR_WAVE_FORMAT_IEEE_FLOAT, 32);
+  read("float", 32);
+  remove(path);
+}
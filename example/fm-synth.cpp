@@ -11,13 +11,23 @@ struct App : AudioVisual {
   Line gain;
   Line frequency;
 
-  void setup() { soundDisplay.setup(4 * blockSize); }
+  // one block of each signal
+  Array hz, level, signal;
+
+  void setup() {
+    soundDisplay.setup(4 * blockSize);
+    hz.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+  }
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      sine.frequency(frequency());
-      float f = sine() * gain();
-      out[i + 1] = out[i + 0] = f;
+    frequency.process(hz.data, blockSize);
+    gain.process(level.data, blockSize);
+    sine.process(signal.data, hz.data, blockSize);
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      float f = signal[i] * level[i];
+      out[1] = out[0] = f;
       soundDisplay(f);
     }
   }
@@ -1,5 +1,7 @@
+#include <atomic>
 #include <mutex>
 #include "AudioPlatform/AudioVisual.h"
+#include "AudioPlatform/BiquadBank.h"
 #include "AudioPlatform/FFT.h"
 #include "AudioPlatform/SoundDisplay.h"
 #include "AudioPlatform/Synths.h"
@@ -12,7 +14,11 @@ struct App : AudioVisual {
   Line gain;
   Line frequency;
 
-  BiquadWithLines f1, f2, f3;
+  // the three formant filters, run side by side. the formant and its
+  // resonance are set by visual() and read by audio().
+  BiquadBank formants;
+  std::atomic<int> form{0};
+  std::atomic<float> reson{3};
 
   float data[28][3]{
       {294, 2343, 3251}, {283, 2170, 2417}, {293, 2186, 2507},
@@ -27,15 +33,33 @@ struct App : AudioVisual {
       {652, 843, 2011},
   };
 
-  void setup() { soundDisplay.setup(4 * blockSize); }
+  // one block of each signal
+  Array hz, level, signal, filtered;
+
+  void setup() {
+    soundDisplay.setup(4 * blockSize);
+    hz.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+    filtered.resize(blockSize);
+    formants.setup(3, blockSize);
+  }
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      saw.frequency(frequency());
-      float s = saw();
-      float f = f1(s) + f2(s) + f3(s) + 2 * s;
+    frequency.process(hz.data, blockSize);
+    gain.process(level.data, blockSize);
+    saw.process(signal.data, hz.data, blockSize);
+
+    // the filters glide to a new formant over the block
+    const float r = reson.load();
+    const float q[3] = {r, r, r};
+    formants.design(BiquadCoefficients::BPF, data[form.load()], q);
+    formants.process(signal.data, filtered.data, blockSize);
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      float f = filtered[i] + 2 * signal[i];
       f /= 5;
-      out[i + 1] = out[i + 0] = f * gain();
+      out[1] = out[0] = f * level[i];
       soundDisplay(f);
     }
   }
@@ -61,16 +85,12 @@ struct App : AudioVisual {
       ImGui::SliderFloat("Frequency (MIDI)", &note, 0, 127);
       frequency.set(mtof(note), 50.0f);
 
-      static float reson = 3;
-      ImGui::SliderFloat("Resonance", &reson, 0.0001, 12);
-
-      //
-      static int form = 0;
-      ImGui::SliderInt("Formant", &form, 0, 27);
-      f1.bpf(data[form][0], reson);
-      f2.bpf(data[form][1], reson);
-      f3.bpf(data[form][2], reson);
-      //
+      static float r = 3;
+      ImGui::SliderFloat("Resonance", &r, 0.0001, 12);
+      reson.store(r);
+      static int f = 0;
+      ImGui::SliderInt("Formant", &f, 0, 27);
+      form.store(f);
 
       soundDisplay();
 
@@ -22,7 +22,7 @@ vector<float> fft_input;
 struct Grain : Array {
   float rms, zcr, centroid, pitch;
 
-  Grain(const Array& clip, unsigned begin, unsigned end) {
+  Grain(const Array& clip, unsigned begin, unsigned end, Arena& arena) {
     // zero crossing rate
 
     zcr = 0;
@@ -31,7 +31,7 @@ struct Grain : Array {
     zcr = sampleRate * zcr / (end - begin) / 2;
 
     // copy and window the grain
-    resize(end - begin);
+    resize(end - begin, arena);
     for (unsigned i = 0; i < size; ++i) {
       float windowIndex = hann_window.size * float(i) / size;
       data[i] = clip[begin + i] * hann_window.get(windowIndex);
@@ -98,13 +98,22 @@ struct Grain : Array {
 };
 
 struct Cloud {
+  // the grains, and all of their samples in one block; both are allocated
+  // once, in setup, and freed together with the cloud
+  Arena arena;
+  vector<Grain> storage;
+
   vector<Grain*> grain;
   set<Grain*> playlist;
   vector<Grain*> rms, centroid, zcr;
 
   void setup(SamplePlayer& player, unsigned length, unsigned hop) {
+    const unsigned count = (player.size - length * 2 + hop - 1) / hop;
+    arena.setup(count * Arena::footprint(length));
+    storage.reserve(count);
     for (unsigned i = 0; i < player.size - length * 2; i += hop) {
-      grain.push_back(new Grain(player, i, i + length));
+      storage.emplace_back(player, i, i + length, arena);
+      grain.push_back(&storage.back());
     }
 
     for (auto p : grain) {
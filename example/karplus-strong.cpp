@@ -39,13 +39,16 @@ struct App : AudioVisual {
   SoundDisplay soundDisplay;
   Noise noise;
   Delay delay;
-  Biquad filter;
+  BiquadWithLines filter;  // glides to the filter slider
   Biquad dcblock;
 
   Timer timer;
 
   Line envelope, gain, feedback;
-  Line filterFrequency, delayFrequency;
+  Line delayFrequency;
+
+  // one block of each signal
+  Array excitation, level;
 
   void setup() {
     timer.ms(600);
@@ -53,19 +56,22 @@ struct App : AudioVisual {
     dcblock.hpf(30, 0.7);
 
     soundDisplay.setup(4 * blockSize);
+    excitation.resize(blockSize);
+    level.resize(blockSize);
   }
 
   void audio(float* out) {
     static float f = 0;
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
+    noise.process(excitation.data, blockSize);
+    gain.process(level.data, blockSize);
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
       if (timer()) envelope.set(1, 0, 150);
 
-      filter.lpf(filterFrequency(), 0.1);
-
-      f = dcblock(filter(delay(noise() * envelope() + feedback() * f / 2)) +
+      f = dcblock(filter(delay(excitation[i] * envelope() +
+                               feedback() * f / 2)) +
                   f / 2);
 
-      out[i + 1] = out[i + 0] = f * gain();
+      out[1] = out[0] = f * level[i];
       soundDisplay(f);
     }
   }
@@ -92,7 +98,7 @@ struct App : AudioVisual {
 
       static float v = 130;
       ImGui::SliderFloat("Filter (Hz)", &v, 100, 134);
-      filterFrequency.set(mtof(v));
+      filter.lpf(mtof(v), 0.1);
 
       static float f = -3;
       ImGui::SliderFloat("Feedback (dB)", &f, -6, 0);
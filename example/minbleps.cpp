@@ -6,71 +6,47 @@
 
 using namespace ap;
 
-struct SawMinBLEP : SamplePlayer {
-  float phase = 0.0f, increment = 0.0f;
-  void frequency(float hz) {
-    increment = hz / sampleRate;
-    // SamplePlayer::frequency(hz * 3);
-  }
-
-  void period(float s) { frequency(1 / s); }
-
-  virtual float operator()() { return nextValue(); }
-
-  virtual float nextValue() {
-    //    float returnValue = phase;
-    phase += increment;
-    if (phase > 1.0f) {
-      // phase wrapped; reset MinBLEP
-      SamplePlayer::phase = 0;
-      phase -= 1.0f;
-    }
-    if (phase < 0.0f) {
-      // phase wrapped; reset MinBLEP
-      SamplePlayer::phase = 0;
-      phase += 1.0f;  // sure; handle negative frequency
-    }
-    return (2 * phase - 1) + (2 - (2 * SamplePlayer::nextValue()));
-    // return (2 * returnValue - 1) + (2 - (2 * SamplePlayer::nextValue()));
-  }
-};
-
 struct App : AudioVisual {
   SoundDisplay soundDisplay;
 
-  SawMinBLEP saw;
+  // a saw, pulse or triangle, hard synced to a master at the played note
+  BlepHardSync synth;
   Line gain;
   Line frequency;
-  Line playerFrequency;
+  Line ratio;
+  std::vector<float> hz, master, sound;
 
   void setup() override {
     soundDisplay.setup(4 * blockSize);
+    hz.resize(blockSize);
+    master.resize(blockSize);
+    sound.resize(blockSize);
 
-    // this loaded sample is the result of...
-    // - taking the bandlimited impulse into the cepstral domain
-    // - zeroing the top 50% of the cepstral data
-    // - bringing this back into the original real/time domain
-    // - integrating
-    // i think that process might be called "liftering"
-    // https://en.wikipedia.org/wiki/Cepstrum#Liftering
-    saw.load("media/MinBLEP.wav");
+    // the band-limited step that these oscillators use was once loaded from
+    // media/MinBLEP.wav; now it is made when the first one is constructed.
+    // see MinBLEP.h.
   }
 
   void audio(float* out) override {
+    // frequencies for the whole block, from the smoothed controls
+    for (unsigned i = 0; i < blockSize; ++i) {
+      master[i] = frequency();
+      hz[i] = master[i] * ratio();
+    }
+
+    // the master writes when it wrapped; the slave restarts at those times
+    synth.master.render(&synth.buffer[0], &master[0], nullptr,
+                        &synth.reset[0], blockSize);
+    synth.slave.render(&sound[0], &hz[0], &synth.reset[0], nullptr,
+                       blockSize);
+
     // for each pair of samples, left and right
     //
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      // set the frequency of the sine oscillator using the Line class to smooth
-      // out jumps control values
-      float v = frequency();
-      saw.frequency(v);
-      saw.SamplePlayer::frequency(v * playerFrequency());
-
-      // compute the next sample
-      float f = saw() * gain();
+    for (unsigned i = 0; i < blockSize; ++i) {
+      float f = sound[i] * gain();
 
       // copy the sample to the right and left output channels
-      out[i + 1] = out[i + 0] = f;
+      out[channelCount * i + 1] = out[channelCount * i + 0] = f;
 
       // save each sample in to a history buffer
       soundDisplay(f);
@@ -97,9 +73,19 @@ struct App : AudioVisual {
     ImGui::SliderFloat("Frequency (MIDI)", &note, 0, 127);
     frequency.set(mtof(note), 50.0f);
 
-    static float freq = 1;
-    ImGui::SliderFloat("factor", &freq, 0, 5);
-    playerFrequency.set(freq, 50.0f);
+    // how many times faster the slave runs; 1 is no sync at all
+    static float r = 1;
+    ImGui::SliderFloat("Sync ratio", &r, 1, 8);
+    ratio.set(r, 50.0f);
+
+    static int type = BlepOscillator::SAW;
+    ImGui::RadioButton("Saw", &type, BlepOscillator::SAW);
+    ImGui::SameLine();
+    ImGui::RadioButton("Pulse", &type, BlepOscillator::PULSE);
+    ImGui::SameLine();
+    ImGui::RadioButton("Triangle", &type, BlepOscillator::TRIANGLE);
+    synth.slave.type = BlepOscillator::Type(type);
+    ImGui::SliderFloat("Pulse width", &synth.slave.width, 0.01f, 0.99f);
 
     soundDisplay();
 
@@ -0,0 +1,75 @@
+#include "AudioPlatform/AudioVisual.h"
+#include "AudioPlatform/MIDI.h"
+#include "AudioPlatform/SoundDisplay.h"
+#include "AudioPlatform/Synths.h"
+#include "AudioPlatform/VoicePool.h"
+
+using namespace ap;
+
+// play SawVoice from a MIDI keyboard, up to 64 notes at once
+
+struct App : AudioVisual {
+  SoundDisplay soundDisplay;
+  MIDI midi;
+  VoicePool<SawVoice, 64> pool;
+  Line gain;
+  unsigned active = 0;
+
+  // one block of each signal
+  Array level, signal;
+
+  void setup() {
+    midi.setup();
+    pool.setup(blockSize);
+    soundDisplay.setup(4 * blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+  }
+
+  void audio(float* out) {
+    // render up to each MIDI event, then act on it, so notes start on the
+    // sample they should rather than at the start of the block
+    unsigned done = 0;
+    MIDI::Event event;
+    midi.block(blockSize);
+    while (midi.next(event)) {
+      pool.process(signal.data + done, event.offset - done);
+      done = event.offset;
+      pool.midi(event);
+    }
+    pool.process(signal.data + done, blockSize - done);
+    active = pool.active();
+
+    gain.process(level.data, blockSize);
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      out[1] = out[0] = signal[i] * level[i];
+      soundDisplay(out[0]);
+    }
+  }
+
+  void visual() {
+    {
+      // this stuff makes a single "root" window
+      int windowWidth, windowHeight;
+      glfwGetWindowSize(window, &windowWidth, &windowHeight);
+      ImGui::SetWindowPos("window", ImVec2(0, 0));
+      ImGui::SetWindowSize("window", ImVec2(windowWidth, windowWidth));
+      ImGui::Begin("window", nullptr,
+                   ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
+                       ImGuiWindowFlags_NoResize);
+
+      // make a slider for "volume" level
+      static float db = -60.0f;
+      ImGui::SliderFloat("Level (dB)", &db, -60.0f, 3.0f);
+      gain.set(dbtoa(db), 50.0f);
+
+      ImGui::Text("%u voices active", active);
+
+      soundDisplay();
+
+      ImGui::End();
+    }
+  }
+};
+
+int main() { App().start(); }
@@ -6,6 +6,7 @@
 #include <vector>
 #include "AudioPlatform/AudioVisual.h"
 #include "AudioPlatform/FFT.h"
+#include "AudioPlatform/OscillatorBank.h"
 #include "AudioPlatform/SoundDisplay.h"
 #include "AudioPlatform/Synths.h"
 
@@ -65,34 +66,30 @@ void load(string dataFile, vector<vector<Data>>& data) {
 struct App : AudioVisual {
   SoundDisplay soundDisplay;
 
-  vector<Sine> sine;
-  vector<Line> gain;
-  vector<Line> freq;
+  // all the partials; frequency and gain changes glide over 15 ms
+  OscillatorBank bank;
   Line masterGain;
   Line position;
 
+  // one block of the sum of the partials
+  Array sum;
+
   void setup() {
     soundDisplay.setup(4 * blockSize);
-
-    sine.resize(data[0].size());
-    gain.resize(data[0].size());
-    freq.resize(data[0].size());
-
-    for (unsigned i = 0; i < data[0].size(); ++i) {
-      freq[i].milliseconds = 15;
-      gain[i].milliseconds = 15;
-    }
+    sum.resize(blockSize);
+    bank.setup(data[0].size());
+    bank.time(15.0f);
   }
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      for (unsigned i = 0; i < sine.size(); ++i) sine[i].frequency(freq[i]());
-      float f = 0;
-      for (unsigned i = 0; i < sine.size(); ++i) f += sine[i]() * gain[i]();
-      f /= sine.size();
+    bank.process(sum.data, blockSize);
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      float f = sum[i];
+      f /= bank.count;
       f *= masterGain();
       f *= 3;  // because its sorta quiet
-      out[i + 1] = out[i + 0] = f;
+      out[1] = out[0] = f;
 
       soundDisplay(f);
     }
@@ -125,10 +122,8 @@ struct App : AudioVisual {
     ImGui::SliderFloat("Postion", &where, 0, 1);
 
     float index = where * frequency[0].size;
-    for (unsigned i = 0; i < frequency.size(); ++i) {
-      freq[i].set(frequency[i].get(index) * shift);
-      gain[i].set(magnitude[i].get(index));
-    }
+    for (unsigned i = 0; i < frequency.size(); ++i)
+      bank.set(i, frequency[i].get(index) * shift, magnitude[i].get(index));
     /*
     unsigned index = floor(where * data.size());
     unsigned i = 0;
@@ -1,4 +1,4 @@
-#include <mutex>
+#include <vector>
 #include "AudioPlatform/AudioVisual.h"
 #include "AudioPlatform/FFT.h"
 #include "AudioPlatform/SoundDisplay.h"
@@ -7,22 +7,40 @@
 using namespace ap;
 
 struct App : AudioVisual {
-  SamplePlayer player;
+  MultiSamplePlayer player;
   Line gain;
   Line frequency;
   SoundDisplay soundDisplay;
 
+  // one block of each signal, and of each channel of the file
+  Array rate, level;
+  std::vector<Array> signal;
+  std::vector<float*> channel;
+
   void setup() {
     player.load("media/Impulse-Sweep.wav");
     soundDisplay.setup(4 * blockSize);
+    rate.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(player.buffer.channels);
+    for (auto& s : signal) {
+      s.resize(blockSize);
+      channel.push_back(s.data);
+    }
+    player.reserve(blockSize);
   }
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      player.frequency(frequency());
-      float f = player();
-      out[i + 1] = out[i + 0] = f * gain();
-      soundDisplay(f);
+    frequency.process(rate.data, blockSize);
+    gain.process(level.data, blockSize);
+    player.process(&channel[0], rate.data, blockSize);
+
+    // left and right from the first two channels (or both from the first)
+    const unsigned right = signal.size() > 1 ? 1 : 0;
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      out[0] = signal[0][i] * level[i];
+      out[1] = signal[right][i] * level[i];
+      soundDisplay(out[0]);
     }
   }
 
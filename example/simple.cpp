@@ -12,17 +12,31 @@ struct App : AudioVisual {
   Line frequency;
 
   Timer timer;
-  void setup() { timer.ms(500); }
+
+  // one block of each signal
+  Array hz, level, signal;
+
+  void setup() {
+    timer.ms(500);
+    hz.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+  }
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
+    for (unsigned i = 0; i < blockSize; ++i) {
       if (timer()) {
         // do somthing every timer period
       }
-      sine.frequency(frequency());
-      float f = sine() * gain();
-      out[i + 1] = out[i + 0] = f;
     }
+
+    // compute a whole block of each signal at once
+    frequency.process(hz.data, blockSize);
+    gain.process(level.data, blockSize);
+    sine.process(signal.data, hz.data, blockSize);
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount)
+      out[1] = out[0] = signal[i] * level[i];
   }
 
   void visual() {
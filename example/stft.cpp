@@ -13,6 +13,9 @@ struct App : AudioVisual {
   SoundDisplay soundDisplay;
   STFT stft;
 
+  // one block of each signal
+  Array rate, level, signal;
+
   void setup() {
     // player.load("media/voice.wav");
     player.load("media/TingTing.wav");
@@ -20,22 +23,28 @@ struct App : AudioVisual {
     // player.load("media/sine.wav");
     soundDisplay.setup(4 * blockSize);
     stft.setup(blockSize * 2);
+    rate.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
   }
 
   int bin = 20;
 
   void audio(float* out) {
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      player.frequency(frequency());
-      float f = player();
-      if (stft(f)) {
-        //
-        for (unsigned i = bin; i < stft.magnitude.size(); ++i)
-          stft.magnitude[i] = 0;
-      }
-      f = stft();
-      out[i + 1] = out[i + 0] = f * gain();
-      soundDisplay(f);
+    frequency.process(rate.data, blockSize);
+    gain.process(level.data, blockSize);
+    player.process(signal.data, rate.data, blockSize);
+
+    // zero the bins above bin; this works on (real, imag) directly, so
+    // there is no conversion to and from (magnitude, phase)
+    stft.process(signal.data, signal.data, blockSize,
+                 [&](float* real, float* imag, unsigned n) {
+                   for (unsigned k = bin; k < n; ++k) real[k] = imag[k] = 0;
+                 });
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      out[1] = out[0] = signal[i] * level[i];
+      soundDisplay(signal[i]);
     }
   }
 
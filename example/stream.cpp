@@ -0,0 +1,72 @@
+#include "AudioPlatform/AudioVisual.h"
+#include "AudioPlatform/SoundDisplay.h"
+#include "AudioPlatform/StreamPlayer.h"
+#include "AudioPlatform/Synths.h"
+
+using namespace ap;
+
+// like sampler.cpp, but the file is streamed from disk rather than loaded,
+// so it may be as long as you like
+
+struct App : AudioVisual {
+  StreamPlayer player;
+  Line gain;
+  Line frequency;
+  SoundDisplay soundDisplay;
+
+  // one block of each signal
+  Array rate, level, signal;
+
+  void setup() {
+    player.load("media/TingTing.wav");
+    soundDisplay.setup(4 * blockSize);
+    rate.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+  }
+
+  void audio(float* out) {
+    frequency.process(rate.data, blockSize);
+    gain.process(level.data, blockSize);
+    player.process(signal.data, rate.data, blockSize);
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      float f = signal[i];
+      out[1] = out[0] = f * level[i];
+      soundDisplay(f);
+    }
+  }
+
+  void visual() {
+    {
+      // this stuff makes a single "root" window
+      int windowWidth, windowHeight;
+      glfwGetWindowSize(window, &windowWidth, &windowHeight);
+      ImGui::SetWindowPos("window", ImVec2(0, 0));
+      ImGui::SetWindowSize("window", ImVec2(windowWidth, windowWidth));
+      ImGui::Begin("window", nullptr,
+                   ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoMove |
+                       ImGuiWindowFlags_NoResize);
+
+      // make a slider for "volume" level
+      static float db = -60.0f;
+      ImGui::SliderFloat("Level (dB)", &db, -60.0f, 3.0f);
+      gain.set(dbtoa(db), 50.0f);
+
+      // playback rate; a stream only goes forward
+      static float rate = 1.0;
+      ImGui::SliderFloat("Rate", &rate, 0.0, 2.1);
+      frequency.set(rate, 20.0f);
+
+      // jump to a point in the file
+      static float where = 0;
+      if (ImGui::SliderFloat("Seek", &where, 0.0, 1.0))
+        player.seek(where * player.frames);
+
+      soundDisplay();
+
+      ImGui::End();
+    }
+  }
+};
+
+int main() { App().start(); }
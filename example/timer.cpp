@@ -1,9 +1,10 @@
 #include <cmath>
-#include <mutex>
 #include "AudioPlatform/AudioVisual.h"
+#include "AudioPlatform/BiquadBank.h"
 #include "AudioPlatform/FFT.h"
 #include "AudioPlatform/SoundDisplay.h"
 #include "AudioPlatform/Synths.h"
+#include "AudioPlatform/TripleBuffer.h"
 
 using namespace ap;
 
@@ -50,41 +51,61 @@ struct App : AudioVisual {
   Line gain;
   Line frequency;
   Delay delay[6];
-  Biquad filter[6];
+  BiquadCascade filter;  // 6 allpasses in series
 
-  std::mutex m;
-  std::vector<float> history, _history;
+  TripleBuffer history;
+  std::vector<float> copy;
   std::vector<float> hann;
 
+  // one block of each signal
+  Array hz, level, signal, filtered;
+
   void setup() {
     timer.ms(130);
     frequency.milliseconds = 10;
 
     for (unsigned i = 0; i < 6; i++) delay[i].ms(100.0 / pow(3.0, i));
     float data[]{200.0f, 300.0f, 500.0f, 700.0f, 1100.0f, 1300.0f};
-    for (unsigned i = 0; i < 6; i++) filter[i].apf(data[i], 0.7);
+    filter.setup(6);
+    for (unsigned i = 0; i < 6; i++) {
+      BiquadCoefficients c;
+      c.apf(data[i], 0.7);
+      filter.set(i, c);
+    }
 
-    history.resize(historySize, 0);
-    _history.resize(historySize, 0);
+    history.setup(historySize);
+    copy.resize(historySize, 0);
     hann.resize(historySize);
     make_hann(hann);
     fft.setup(historySize);
+
+    hz.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+    filtered.resize(blockSize);
   }
 
   void audio(float* out) {
     static unsigned n = 0;
 
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
+    // the timer changes the frequency target mid-block, so we fill the
+    // frequency block one sample at a time
+    for (unsigned i = 0; i < blockSize; ++i) {
       if (timer()) frequency.set(mtof(r(0, 127)));
-      sine.frequency(frequency());
-      float f = sine();
-      float a =
-          filter[0](filter[1](filter[2](filter[3](filter[4](filter[5](f))))));
+      hz[i] = frequency();
+    }
+    gain.process(level.data, blockSize);
+    sine.process(signal.data, hz.data, blockSize);
+    filter.process(signal.data, filtered.data, blockSize);
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      float f = signal[i];
+      float a = filtered[i];
       float d = 0;
       for (unsigned i = 0; i < 6; i++) d += delay[i](a * 2);
       f += 0.5 * d;
-      out[i + 1] = out[i + 0] = f * gain();
-      _history[n] = f;
+      out[1] = out[0] = f * level[i];
+      history.write()[n] = f;
       n++;
     }
 
@@ -93,11 +114,8 @@ struct App : AudioVisual {
       // start a new history
       n = 0;
 
-      // *maybe* copy the history buffer for the visual thread to use
-      if (m.try_lock()) {
-        memcpy(&history[0], &_history[0], historySize * sizeof(float));
-        m.unlock();
-      }
+      // hand the history to the visual thread; this never waits
+      history.publish();
     }
   }
 
@@ -117,34 +135,27 @@ struct App : AudioVisual {
       ImGui::SliderFloat("Level (dB)", &db, -60.0f, 3.0f);
       gain.set(dbtoa(db), 50.0f);
 
-      // get the lock (mutex); this will block, waiting for the audio thread to
-      // release the lock. lock() waits while try_lock() does not.
-      m.lock();
+      // get the newest complete history; the audio thread leaves this
+      // buffer alone until we call read() again, so we need no lock
+      const float* frame = history.read();
 
       // use the history buffer to draw the waveform
-      ImGui::PlotLines("Waveform", &history[0], historySize, 0, "", FLT_MAX,
-                       FLT_MAX, ImVec2(0, 50));
-
-      // make a copy
-      float copy[historySize];
-      memcpy(copy, &history[0], historySize * sizeof(float));
-      // window the data
-      for (unsigned i = 0; i < historySize; ++i) copy[i] *= hann[i];
+      ImGui::PlotLines("Waveform", frame, historySize, 0, "", FLT_MAX, FLT_MAX,
+                       ImVec2(0, 50));
+
+      // window a copy of the data
+      for (unsigned i = 0; i < historySize; ++i) copy[i] = frame[i] * hann[i];
       // take the FFT
       fft.forward(&copy[0]);
 
-      // release the lock; this is important. if you don't release the lock,
-      // then the audio thread can never get the lock, so it can never copy any
-      // history and we'll stop getting updates. we can release the lock as soon
-      // as we are done using the history vector
-      m.unlock();
-
       // convert to dB scale on the y axis
-      for (auto& f : fft.magnitude) f = atodb(f);
+      float* m = fft.magnitude.write();
+      for (unsigned i = 0; i < fft.magnitude.size(); ++i) m[i] = atodb(m[i]);
 
       // draw the spectrum, linear in frequency
-      ImGui::PlotLines("Spectrum", &fft.magnitude[0], fft.magnitude.size(), 0,
-                       "", FLT_MAX, FLT_MAX, ImVec2(0, 50));
+      ImGui::PlotLines("Spectrum", fft.magnitude.data(),
+                       fft.magnitude.size(), 0, "", FLT_MAX, FLT_MAX,
+                       ImVec2(0, 50));
 
       // draw the spectrum, LOG in frequency
       ImDrawList* drawList = ImGui::GetWindowDrawList();
@@ -119,7 +119,15 @@ struct MyApp : AudioVisual {
   Tube tube;
   Sine osc;
 
-  void setup() { soundDisplay.setup(blockSize * 4); }
+  // one block of each signal
+  Array hz, level, signal;
+
+  void setup() {
+    soundDisplay.setup(blockSize * 4);
+    hz.resize(blockSize);
+    level.resize(blockSize);
+    signal.resize(blockSize);
+  }
 
   void visual() {
     {
@@ -162,11 +170,14 @@ struct MyApp : AudioVisual {
   void audio(float* out) {
     tube.recalculate();
 
-    for (unsigned i = 0; i < blockSize * channelCount; i += channelCount) {
-      osc.frequency(frequency());
-      double d = osc();
-      double f = tube((d < 0.0) ? 0.0 : d) * gain();
-      out[i + 1] = out[i + 0] = f;
+    frequency.process(hz.data, blockSize);
+    gain.process(level.data, blockSize);
+    osc.process(signal.data, hz.data, blockSize);
+
+    for (unsigned i = 0; i < blockSize; ++i, out += channelCount) {
+      double d = signal[i];
+      double f = tube((d < 0.0) ? 0.0 : d) * level[i];
+      out[1] = out[0] = f;
       soundDisplay(f);
     }
   }
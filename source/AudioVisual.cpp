@@ -10,10 +10,15 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <map>
+#include <vector>
 
 #include "AudioPlatform/Globals.h"
+#include "AudioPlatform/Wav.h"
 
 namespace ap {
 
@@ -53,15 +58,60 @@ static int chooseDevice(RtAudio &audio) {
 }
 #endif
 
+// the rate the device supports that is closest to the one asked for
+static float chooseSampleRate(RtAudio &audio, unsigned device, float wanted) {
+  RtAudio::DeviceInfo info = audio.getDeviceInfo(device);
+  if (!info.probed || info.sampleRates.empty()) return wanted;
+  unsigned best = info.sampleRates[0];
+  for (unsigned rate : info.sampleRates)
+    if (fabs(rate - wanted) < fabs(best - wanted)) best = rate;
+  return best;
+}
+
 static int cb(void *outputBuffer, void *inputBuffer, unsigned int nBufferFrames,
               double streamTime, RtAudioStreamStatus status, void *data) {
-  reinterpret_cast<AudioVisual *>(data)->audio((float *)outputBuffer);
+  reinterpret_cast<AudioVisual *>(data)->callback((float *)outputBuffer,
+                                                  nBufferFrames);
   if (status) std::cout << "Stream underflow detected!" << std::endl;
   return 0;
 }
 
-void AudioVisual::start() {
-  setup();
+void AudioVisual::callback(float *out, unsigned frames) {
+  while (frames > 0) {
+    // whole blocks go straight to the device, once nothing is left over
+    if (pending == 0 && frames >= blockSize) {
+      audio(out);
+      out += blockSize * channelCount;
+      frames -= blockSize;
+      continue;
+    }
+    if (pending == 0) {
+      std::fill(fifo.begin(), fifo.end(), 0.0f);
+      audio(&fifo[0]);
+      pending = blockSize;
+    }
+    const unsigned n = frames < pending ? frames : pending;
+    const float *from = &fifo[(blockSize - pending) * channelCount];
+    std::copy(from, from + n * channelCount, out);
+    out += n * channelCount;
+    frames -= n;
+    pending -= n;
+  }
+}
+
+AudioVisual::AudioVisual() {
+  const char *rate = getenv("AP_SAMPLE_RATE");
+  if (rate != nullptr) sampleRate = atof(rate);
+  const char *frames = getenv("AP_BLOCK_SIZE");
+  if (frames != nullptr) blockSize = atoi(frames);
+  if (blockSize == 0 || (blockSize & (blockSize - 1)) != 0)
+    die("blockSize (or AP_BLOCK_SIZE) must be a power of two, not %u",
+        blockSize);
+
+  if (getenv("AP_RENDER") == nullptr) open();
+}
+
+void AudioVisual::open() {
   std::map<int, std::string> apiMap;
   apiMap[RtAudio::MACOSX_CORE] = "OS-X Core Audio";
   apiMap[RtAudio::WINDOWS_ASIO] = "Windows ASIO";
@@ -109,14 +159,36 @@ void AudioVisual::start() {
   // options.flags = RTAUDIO_HOG_DEVICE;
   options.flags |= RTAUDIO_SCHEDULE_REALTIME;
 
+  // the device may not do the rate asked for; what it does becomes the
+  // engine's. this runs before the app's members are made, so they are all
+  // made with the real rate. blockSize stays as asked, whatever the device
+  // calls back with; callback() makes up the difference.
+  try {
+    unsigned frames = blockSize;
+    dac->openStream(&oParams, NULL, RTAUDIO_FLOAT32,
+                    chooseSampleRate(*dac, oParams.deviceId, sampleRate),
+                    &frames, &cb, (void *)this, &options, nullptr);
+    sampleRate = dac->getStreamSampleRate();
+    fifo.assign(blockSize * channelCount, 0.0f);
+    printf("Audio: %g Hz, %u frames per block, %u per device callback\n",
+           sampleRate, blockSize, frames);
+  } catch (RtAudioError &e) {
+    e.printMessage();
+    if (dac->isStreamOpen()) dac->closeStream();
+    exit(1);
+  }
+}
+
+void AudioVisual::start() {
+  const char *renderPath = getenv("AP_RENDER");
+  if (renderPath != nullptr) {
+    const char *seconds = getenv("AP_RENDER_SECONDS");
+    render(renderPath, seconds ? atof(seconds) : 10.0f);
+    return;
+  }
+
+  setup();
   try {
-    unsigned bs = blockSize;
-    dac->openStream(&oParams, NULL, RTAUDIO_FLOAT32, sampleRate, &bs, &cb,
-                    (void *)this, &options, nullptr);
-    if (bs != blockSize) {
-      printf("FAIL");
-      exit(2);
-    }
     dac->startStream();
   } catch (RtAudioError &e) {
     e.printMessage();
@@ -172,4 +244,36 @@ void AudioVisual::start() {
   glfwTerminate();
 }
 
+void AudioVisual::render(std::string filePath, float seconds) {
+  setup();
+
+  drwav_data_format format;
+  format.channels = channelCount;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+  format.sampleRate = sampleRate;
+  format.bitsPerSample = 32;
+  drwav *pWav = drwav_open_file_write(filePath.c_str(), &format);
+  if (pWav == nullptr) die("failed to open %s", filePath.c_str());
+
+  std::vector<float> block(blockSize * channelCount);
+  unsigned blockCount = ceil(seconds * sampleRate / blockSize);
+
+  auto begin = std::chrono::steady_clock::now();
+  for (unsigned b = 0; b < blockCount; ++b) {
+    for (auto &f : block) f = 0.0f;
+    audio(&block[0]);
+    if (drwav_write(pWav, block.size(), &block[0]) != block.size())
+      die("failed to write %s", filePath.c_str());
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  drwav_close(pWav);
+
+  double rendered = double(blockCount) * blockSize / sampleRate;
+  printf("%s -> %.3f seconds in %.3f seconds (%.1fx real time)\n",
+         filePath.c_str(), rendered, elapsed.count(),
+         rendered / elapsed.count());
+}
+
 }  // namespace ap
@@ -0,0 +1,96 @@
+#include "AudioPlatform/Convolver.h"
+
+#include <string.h>
+
+namespace ap {
+
+void Convolver::setup(const float* ir, unsigned irSize, unsigned blockSize) {
+  this->blockSize = blockSize;
+  complexSize = audiofft::AudioFFT::ComplexSize(2 * blockSize);
+  partitions = (irSize + blockSize - 1) / blockSize;
+  if (partitions == 0) partitions = 1;
+  fft.init(2 * blockSize);
+
+  input.assign(2 * blockSize, 0);
+  output.assign(2 * blockSize, 0);
+  filterReal.assign(partitions * complexSize, 0);
+  filterImag.assign(partitions * complexSize, 0);
+  historyReal.assign(partitions * complexSize, 0);
+  historyImag.assign(partitions * complexSize, 0);
+  sumReal.assign(complexSize, 0);
+  sumImag.assign(complexSize, 0);
+  current = 0;
+
+  // transform each partition, zero-padded to twice the block size
+  std::vector<float> padded(2 * blockSize);
+  for (unsigned p = 0; p < partitions; ++p) {
+    for (unsigned i = 0; i < 2 * blockSize; ++i) {
+      unsigned j = p * blockSize + i;
+      padded[i] = (i < blockSize && j < irSize) ? ir[j] : 0.0f;
+    }
+    fft.fft(&padded[0], &filterReal[p * complexSize],
+            &filterImag[p * complexSize]);
+  }
+}
+
+void Convolver::reset() {
+  for (auto& f : input) f = 0;
+  for (auto& f : historyReal) f = 0;
+  for (auto& f : historyImag) f = 0;
+}
+
+void Convolver::process(const float* in, float* out) {
+  // slide the input along by one block
+  memmove(&input[0], &input[blockSize], blockSize * sizeof(float));
+  memcpy(&input[blockSize], in, blockSize * sizeof(float));
+
+  // the newest spectrum goes in the oldest slot
+  current = (current == 0) ? partitions - 1 : current - 1;
+  fft.fft(&input[0], &historyReal[current * complexSize],
+          &historyImag[current * complexSize]);
+
+  // multiply each block of history with its partition and sum
+  for (unsigned k = 0; k < complexSize; ++k) sumReal[k] = sumImag[k] = 0;
+  unsigned slot = current;
+  for (unsigned p = 0; p < partitions; ++p) {
+    const float* xr = &historyReal[slot * complexSize];
+    const float* xi = &historyImag[slot * complexSize];
+    const float* hr = &filterReal[p * complexSize];
+    const float* hi = &filterImag[p * complexSize];
+    for (unsigned k = 0; k < complexSize; ++k) {
+      sumReal[k] += xr[k] * hr[k] - xi[k] * hi[k];
+      sumImag[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+    slot++;
+    if (slot >= partitions) slot = 0;
+  }
+
+  // the first half of the result is circular garbage; the second half is
+  // the next block of output (that's the "save" in overlap-save)
+  fft.ifft(&output[0], &sumReal[0], &sumImag[0]);
+  memcpy(out, &output[blockSize], blockSize * sizeof(float));
+}
+
+void Convolver::convolve(const float* f, unsigned fSize, const float* g,
+                         unsigned gSize, std::vector<float>& fg) {
+  // a block about the size of the impulse response keeps the number of
+  // partitions small
+  unsigned blockSize = 64;
+  while (blockSize < gSize && blockSize < 32768) blockSize *= 2;
+
+  Convolver convolver;
+  convolver.setup(g, gSize, blockSize);
+
+  fg.assign(fSize + gSize - 1, 0);
+  std::vector<float> in(blockSize), out(blockSize);
+  for (unsigned i = 0; i < fg.size(); i += blockSize) {
+    // the next block of f, padded with zeros past its end
+    for (unsigned j = 0; j < blockSize; ++j)
+      in[j] = (i + j < fSize) ? f[i + j] : 0.0f;
+    convolver.process(&in[0], &out[0]);
+    for (unsigned j = 0; j < blockSize && i + j < fg.size(); ++j)
+      fg[i + j] = out[j];
+  }
+}
+
+}  // namespace ap
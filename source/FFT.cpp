@@ -1,5 +1,9 @@
 #include "AudioPlatform/FFT.h"
+#include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstring>
+#include "AudioPlatform/FastMath.h"
 #include "AudioPlatform/Functions.h"
 
 namespace ap {
@@ -7,122 +11,164 @@ namespace ap {
 void FFT::setup(unsigned size) {
   this->size = size;
   init(size);
-  magnitude.resize(audiofft::AudioFFT::ComplexSize(size), 0);
-  phase.resize(audiofft::AudioFFT::ComplexSize(size), 0);
+  const unsigned n = audiofft::AudioFFT::ComplexSize(size);
+  real.assign(n, 0);
+  imag.assign(n, 0);
+  magnitude.fft = phase.fft = this;
+  magnitude.value.assign(n, 0);
+  phase.value.assign(n, 0);
+  rectangularValid = polarValid = true;
 }
 
 void FFT::forward(const float* data) {
-  // make aliases for the magnitude and phase vectors
-  float* real = &magnitude[0];
-  float* imag = &phase[0];
+  fft(data, &real[0], &imag[0]);
+  rectangularValid = true;
+  polarValid = false;
+}
 
-  // compute the FFT
-  fft(data, real, imag);
+void FFT::reverse(float* data) {
+  if (!rectangularValid) rectangular();
+  ifft(data, &real[0], &imag[0]);
+}
 
+void FFT::polar() {
   // convert to (magnitude, phase) representation
-  for (unsigned i = 0; i < phase.size(); ++i) {
-    float m = sqrt(real[i] * real[i] + imag[i] * imag[i]);
-
-    // XXX this (below) is not good enough...
-    //  float p = (real[i] == 0.0f) ? M_PI / 2 : atan(imag[i] / real[i]);
-
-    // calculating phase is this complicated...
-    // https://stackoverflow.com/questions/9453714/converting-real-and-imaginary-fft-output-to-frequency-and-amplitude#9454906
-    float p = 0;
-    if (real[i] == 0.0f)
-      if (imag[i] > 0.0f)
-        // pi/2 on the positive y-axis
-        p = M_PI / 2;
-      else
-        // -pi/2 on the negative y-axis
-        p = -M_PI / 2;
-    else if (real[i] > 0)
-      // arctan(b/a) in quadrants I and IV
-      p = atan(imag[i] / real[i]);
-    else if (imag[i] > 0.0f)
-      // arctan(b/a) + pi in quadrant II
-      p = atan(imag[i] / real[i]) + M_PI;
-    else
-      // arctan(b/a) - pi in quadrant III
-      p = atan(imag[i] / real[i]) - M_PI;
+  float* m = &magnitude.value[0];
+  float* p = &phase.value[0];
+  const unsigned n = real.size();
+  if (conversion == FAST)
+    toPolar(&real[0], &imag[0], m, p, n);
+  else
+    for (unsigned i = 0; i < n; ++i) {
+      m[i] = std::sqrt(real[i] * real[i] + imag[i] * imag[i]);
+      p[i] = std::atan2(imag[i], real[i]);
+    }
+  polarValid = true;
+}
 
-    // it is very important that the next lines be separate and after the
-    // previous lines because we are modifying data "in place".
-    magnitude[i] = m;
-    phase[i] = p;
+void FFT::rectangular() {
+  // convert to (real, imaginary) representation, if magnitude or phase have
+  // been changed. after this, real and imag may be changed, so the polar
+  // representation is out of date.
+  if (!rectangularValid) {
+    const float* m = &magnitude.value[0];
+    const float* p = &phase.value[0];
+    const unsigned n = real.size();
+    if (conversion == FAST)
+      toRectangular(m, p, &real[0], &imag[0], n);
+    else
+      for (unsigned i = 0; i < n; ++i) {
+        real[i] = m[i] * std::cos(p[i]);
+        imag[i] = m[i] * std::sin(p[i]);
+      }
+    rectangularValid = true;
   }
+  polarValid = false;
 }
 
-void FFT::reverse(float* data) {
-  // make aliases for the magnitude and phase vectors
-  float* real = &magnitude[0];
-  float* imag = &phase[0];
-
-  // convert to (real, imaginary) representation
-  for (unsigned k = 0; k < phase.size(); ++k) {
-    float r = magnitude[k] * cos(phase[k]);
-    float i = magnitude[k] * sin(phase[k]);
-    // it is very important that the next lines be separate and after the
-    // previous lines because we are modifying data "in place".
-    real[k] = r;
-    imag[k] = i;
+void STFT::setup(unsigned windowSize, unsigned overlap) {
+  std::vector<float> window;
+  hann(window, windowSize);
+  for (auto& e : window) e = std::sqrt(e);
+  setup(windowSize, overlap, window, window);
+}
+
+void STFT::setup(unsigned windowSize, unsigned overlap,
+                 const std::vector<float>& analysis,
+                 const std::vector<float>& synthesis) {
+  assert(0 < overlap && overlap <= windowSize);
+  this->windowSize = windowSize;
+  this->overlap = overlap;
+  hop = windowSize / overlap;
+  FFT::setup(windowSize);
+  this->analysis = analysis;
+  this->synthesis = synthesis;
+  this->analysis.resize(windowSize, 0);
+  this->synthesis.resize(windowSize, 0);
+
+  // each output sample is the sum of overlap frames, at the same position
+  // modulo hop. scale the synthesis window so that sum is 1.
+  for (unsigned j = 0; j < hop; ++j) {
+    float sum = 0;
+    for (unsigned i = j; i < windowSize; i += hop)
+      sum += this->analysis[i] * this->synthesis[i];
+    if (sum > 0)
+      for (unsigned i = j; i < windowSize; i += hop)
+        this->synthesis[i] /= sum;
   }
 
-  // compute the FFT
-  ifft(data, real, imag);
+  input.assign(windowSize, 0);
+  output.assign(windowSize, 0);
+  frame.assign(windowSize, 0);
+  fill = 0;
 }
 
-void STFT::setup(unsigned _windowSize) {
-  windowSize = _windowSize;
-  hop = windowSize / 2;
-  FFT::setup(windowSize);
-  hann(window, windowSize);
-  for (auto& e : window) e = sqrt(e);
-
-  //
-  //
-  in[0].resize(windowSize, 0);
-  in[1].resize(windowSize, 0);
-  out[0].resize(windowSize, 0);
-  out[1].resize(windowSize, 0);
-
-  // start out of phase
-  //
-  in[0].n = hop;
-  in[1].n = 0;
-  out[0].n = hop;
-  out[1].n = 0;
+void STFT::analyze() {
+  float* x = &input[0];
+  float* y = &frame[0];
+  const float* w = &analysis[0];
+  for (unsigned i = 0; i < windowSize; ++i) y[i] = x[i] * w[i];
+  FFT::forward(y);
+
+  // slide the input along by one hop
+  std::memmove(x, x + hop, sizeof(float) * (windowSize - hop));
 }
 
-bool STFT::operator()(float f) {
-  // assume we did not do an FFT
-  //
-  bool returnValue = false;
-  for (unsigned i = 0; i < 2; i++) {
-    in[i].at(in[i].n) = f * window[in[i].n];
-    in[i].n++;
-    if (in[i].n >= in[i].size()) {
-      // that f up there was the final sample we needed to
-      // do our next FFT
-      in[i].n = 0;
-      FFT::forward(&in[i][0]);
-      returnValue = true;
+void STFT::synthesize() {
+  float* x = &frame[0];
+  float* y = &output[0];
+  const float* w = &synthesis[0];
+  FFT::reverse(x);
+
+  // slide the output along by one hop, then overlap-add the frame
+  std::memmove(y, y + hop, sizeof(float) * (windowSize - hop));
+  std::memset(y + windowSize - hop, 0, sizeof(float) * hop);
+  for (unsigned i = 0; i < windowSize; ++i) y[i] += x[i] * w[i];
+}
+
+void STFT::process(const float* in, float* out, unsigned n,
+                   const std::function<void(void)>& process) {
+  while (n) {
+    // copy up to the end of this hop; in and out may alias, so read first
+    const unsigned k = std::min(n, hop - fill);
+    std::memcpy(&input[windowSize - hop + fill], in, sizeof(float) * k);
+    std::memcpy(out, &output[fill], sizeof(float) * k);
+    in += k;
+    out += k;
+    n -= k;
+    fill += k;
+
+    if (fill == hop) {
+      analyze();
+      process();
+      synthesize();
+      fill = 0;
     }
   }
-  return returnValue;
+}
+
+void STFT::process(const float* in, float* out, unsigned n,
+                   const ComplexProcess& process) {
+  STFT::process(in, out, n, [&]() {
+    rectangular();
+    process(&real[0], &imag[0], real.size());
+  });
+}
+
+bool STFT::operator()(float f) {
+  input[windowSize - hop + fill] = f;
+  if (fill + 1 < hop) return false;
+  analyze();
+  return true;
 }
 
 float STFT::operator()() {
-  float sum = 0;
-  for (unsigned i = 0; i < 2; i++) {
-    if (out[i].n >= out[i].size()) out[i].n = 0;
-    // if we're about to output the very first (0th) sample
-    // of a block, then take the IFFT
-    if (out[i].n == 0) FFT::reverse(&out[i][0]);
-    sum += out[i].at(out[i].n) * window[out[i].n];
-    out[i].n++;
+  const float f = output[fill];
+  if (++fill == hop) {
+    synthesize();
+    fill = 0;
   }
-  return sum;
+  return f;
 }
 
 float STFT::operator()(float f, std::function<void(void)> process) {
@@ -130,4 +176,12 @@ float STFT::operator()(float f, std::function<void(void)> process) {
   return operator()();
 }
 
+float STFT::operator()(float f, ComplexProcess process) {
+  if (operator()(f)) {
+    rectangular();
+    process(&real[0], &imag[0], real.size());
+  }
+  return operator()();
+}
+
 }  // namespace ap
@@ -0,0 +1,205 @@
+#include "AudioPlatform/FastMath.h"
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace ap {
+
+void toPolar(const float* re, const float* im, float* magnitude, float* phase,
+             unsigned n) {
+  unsigned i = 0;
+#if defined(__SSE2__)
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 halfPi = _mm_set1_ps(1.57079637f);
+  const __m128 pi = _mm_set1_ps(3.14159274f);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 x = _mm_loadu_ps(re + i);
+    const __m128 y = _mm_loadu_ps(im + i);
+    const __m128 m =
+        _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)));
+
+    // as in fastAtan2, without branches
+    const __m128 ax = _mm_andnot_ps(sign, x);
+    const __m128 ay = _mm_andnot_ps(sign, y);
+    const __m128 mx = _mm_max_ps(ax, ay);
+    const __m128 mn = _mm_min_ps(ax, ay);
+    const __m128 a = _mm_and_ps(_mm_div_ps(mn, mx), _mm_cmpgt_ps(mx, zero));
+    const __m128 s = _mm_mul_ps(a, a);
+    __m128 r = _mm_set1_ps(0.0208351f);
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.0851330f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.1801410f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(-0.3302995f));
+    r = _mm_add_ps(_mm_mul_ps(r, s), _mm_set1_ps(0.9998660f));
+    r = _mm_mul_ps(r, a);
+
+    __m128 flip = _mm_cmpgt_ps(ay, ax);
+    r = _mm_or_ps(_mm_and_ps(flip, _mm_sub_ps(halfPi, r)),
+                  _mm_andnot_ps(flip, r));
+    flip = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+    r = _mm_or_ps(_mm_and_ps(flip, _mm_sub_ps(pi, r)), _mm_andnot_ps(flip, r));
+    r = _mm_xor_ps(r, _mm_and_ps(y, sign));
+
+    _mm_storeu_ps(magnitude + i, m);
+    _mm_storeu_ps(phase + i, r);
+  }
+#endif
+  for (; i < n; ++i) {
+    const float x = re[i], y = im[i];
+    magnitude[i] = std::sqrt(x * x + y * y);
+    phase[i] = fastAtan2(y, x);
+  }
+}
+
+void toRectangular(const float* magnitude, const float* phase, float* re,
+                   float* im, unsigned n) {
+  unsigned i = 0;
+#if defined(__SSE2__)
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  for (; i + 4 <= n; i += 4) {
+    const __m128 m = _mm_loadu_ps(magnitude + i);
+    const __m128 x = _mm_loadu_ps(phase + i);
+
+    // as in fastSinCos; round half away from zero like the scalar version
+    const __m128 f = _mm_mul_ps(x, _mm_set1_ps(0.636619772f));
+    const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(f, sign));
+    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(f, half));
+    const __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(1.5703125f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(4.837512969970703125e-4f)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(7.54978995489188216e-8f)));
+    const __m128 z = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), s));
+
+    __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(z, z), c);
+    c = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f),
+                              _mm_mul_ps(_mm_set1_ps(0.5f), z)),
+                   c);
+
+    // pick and negate by quadrant
+    const __m128 swap =
+        _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+    __m128 sin = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 cos = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    sin = _mm_xor_ps(
+        sin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)));
+    cos = _mm_xor_ps(cos, _mm_castsi128_ps(_mm_slli_epi32(
+                              _mm_and_si128(_mm_add_epi32(q, one), two), 30)));
+
+    _mm_storeu_ps(re + i, _mm_mul_ps(m, cos));
+    _mm_storeu_ps(im + i, _mm_mul_ps(m, sin));
+  }
+#endif
+  for (; i < n; ++i) {
+    float s, c;
+    fastSinCos(phase[i], s, c);
+    const float m = magnitude[i];
+    re[i] = m * c;
+    im[i] = m * s;
+  }
+}
+
+void fastExp2(const float* in, float* out, unsigned n, Precision precision) {
+  const float* c = exp2Polynomial[precision];
+  const int degree = exp2Degree[precision];
+  unsigned i = 0;
+#if defined(__SSE2__)
+  const __m128 sign = _mm_set1_ps(-0.0f);
+  for (; i + 4 <= n; i += 4) {
+    // as in fastExp2; round half away from zero like the scalar version
+    const __m128 in4 = _mm_loadu_ps(in + i);
+    const __m128 x = _mm_min_ps(_mm_max_ps(in4, _mm_set1_ps(-127.0f)),
+                                _mm_set1_ps(127.0f));
+    const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(x, sign));
+    const __m128i q = _mm_cvttps_epi32(_mm_add_ps(x, half));
+    const __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(q));
+    __m128 p = _mm_set1_ps(c[degree]);
+    for (int k = degree - 1; k >= 0; --k)
+      p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(c[k]));
+    const __m128i bits =
+        _mm_slli_epi32(_mm_add_epi32(q, _mm_set1_epi32(127)), 23);
+    const __m128 r = _mm_mul_ps(p, _mm_castsi128_ps(bits));
+
+    // from 128 up, and NaN (which max and min turned into -127)
+    const __m128 big = _mm_cmpnlt_ps(in4, _mm_set1_ps(128.0f));
+    const __m128 inf = _mm_add_ps(in4, _mm_set1_ps(HUGE_VALF));
+    _mm_storeu_ps(out + i,
+                  _mm_or_ps(_mm_and_ps(big, inf), _mm_andnot_ps(big, r)));
+  }
+#endif
+  for (; i < n; ++i) out[i] = fastExp2(in[i], precision);
+}
+
+void fastLog2(const float* in, float* out, unsigned n, Precision precision) {
+  const float* c = log2Polynomial[precision];
+  const int degree = log2Degree[precision];
+  unsigned i = 0;
+#if defined(__SSE2__)
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 inf = _mm_set1_ps(HUGE_VALF);
+  for (; i + 4 <= n; i += 4) {
+    // as in fastLog2, without branches
+    __m128 x = _mm_loadu_ps(in + i);
+    const __m128 tiny = _mm_cmplt_ps(x, _mm_set1_ps(1.17549435e-38f));
+    x = _mm_or_ps(_mm_and_ps(tiny, _mm_mul_ps(x, _mm_set1_ps(8388608.0f))),
+                  _mm_andnot_ps(tiny, x));
+    const __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(
+        _mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(255)),
+        _mm_add_epi32(_mm_set1_epi32(127),
+                      _mm_and_si128(_mm_castps_si128(tiny),
+                                    _mm_set1_epi32(23))));
+    __m128 m = _mm_castsi128_ps(
+        _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)),
+                     _mm_set1_epi32(0x3F800000)));
+    const __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))),
+                  _mm_andnot_ps(big, m));
+    e = _mm_sub_epi32(e, _mm_castps_si128(big));  // the mask is -1
+
+    const __m128 s = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+    const __m128 z = _mm_mul_ps(s, s);
+    __m128 p = _mm_set1_ps(c[degree]);
+    for (int k = degree - 1; k >= 0; --k)
+      p = _mm_add_ps(_mm_mul_ps(p, z), _mm_set1_ps(c[k]));
+    const __m128 ln = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(2.0f), s), p);
+    const __m128 log2 = _mm_mul_ps(ln, _mm_set1_ps(1.44269504f));
+    __m128 r = _mm_add_ps(_mm_cvtepi32_ps(e), log2);
+
+    // 0 to -inf, negatives and NaN to NaN, +inf to itself
+    const __m128 positive = _mm_cmpgt_ps(x, zero);
+    r = _mm_or_ps(_mm_and_ps(positive, r),
+                  _mm_andnot_ps(positive, _mm_set1_ps(NAN)));
+    const __m128 naught = _mm_cmpeq_ps(x, zero);
+    r = _mm_or_ps(_mm_and_ps(naught, _mm_sub_ps(zero, inf)),
+                  _mm_andnot_ps(naught, r));
+    const __m128 huge = _mm_cmpeq_ps(x, inf);
+    r = _mm_or_ps(_mm_and_ps(huge, inf), _mm_andnot_ps(huge, r));
+    _mm_storeu_ps(out + i, r);
+  }
+#endif
+  for (; i < n; ++i) out[i] = fastLog2(in[i], precision);
+}
+
+void fastTanh(const float* in, float* out, unsigned n, Precision precision) {
+  for (unsigned i = 0; i < n; ++i) {
+    const float x = in[i] < -9.0f ? -9.0f : (in[i] > 9.0f ? 9.0f : in[i]);
+    out[i] = 2.88539008f * x;
+  }
+  fastExp2(out, out, n, precision);
+  for (unsigned i = 0; i < n; ++i) out[i] = 1.0f - 2.0f / (out[i] + 1.0f);
+}
+
+}  // namespace ap
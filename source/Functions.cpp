@@ -1,14 +1,37 @@
 #include "AudioPlatform/Functions.h"
+#include "AudioPlatform/FastMath.h"
+#include "AudioPlatform/Noise.h"
 #include "AudioPlatform/Types.h"
 
 #include <cmath>
 
 namespace ap {
 
-float mtof(float m) { return 8.175799f * powf(2.0f, m / 12.0f); }
-float ftom(float f) { return 12.0f * log2f(f / 8.175799f); }
-float dbtoa(float db) { return 1.0f * powf(10.0f, db / 20.0f); }
-float atodb(float a) { return 20.0f * log10f(a / 1.0f); }
+// through fastExp2 and fastLog2; the array versions do the same arithmetic
+float mtof(float m) { return 8.175799f * fastExp2(m * (1.0f / 12.0f)); }
+// log2(8.175799); subtracted rather than dividing f first, which would
+// flush the smallest denormals to 0
+float ftom(float f) { return 12.0f * (fastLog2(f) - 3.03135971f); }
+float dbtoa(float db) { return fastExp2(db * 0.166096405f); }  // log2(10)/20
+float atodb(float a) { return 6.02059991f * fastLog2(a); }      // 20 log10(2)
+
+void mtof(const float* m, float* f, unsigned n) {
+  for (unsigned i = 0; i < n; ++i) f[i] = m[i] * (1.0f / 12.0f);
+  fastExp2(f, f, n);
+  for (unsigned i = 0; i < n; ++i) f[i] *= 8.175799f;
+}
+void ftom(const float* f, float* m, unsigned n) {
+  fastLog2(f, m, n);
+  for (unsigned i = 0; i < n; ++i) m[i] = 12.0f * (m[i] - 3.03135971f);
+}
+void dbtoa(const float* db, float* a, unsigned n) {
+  for (unsigned i = 0; i < n; ++i) a[i] = db[i] * 0.166096405f;
+  fastExp2(a, a, n);
+}
+void atodb(const float* a, float* db, unsigned n) {
+  fastLog2(a, db, n);
+  for (unsigned i = 0; i < n; ++i) db[i] *= 6.02059991f;
+}
 
 void hann(Array& window, unsigned size) {
   window.resize(size);
@@ -22,6 +45,32 @@ void hann(std::vector<float>& window, unsigned size) {
     window[i] = (1 - cos(2 * M_PI * i / size)) / 2;
 }
 
+void hamming(Array& window, unsigned size) {
+  window.resize(size);
+  for (unsigned i = 0; i < size; ++i)
+    window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / size);
+}
+
+void hamming(std::vector<float>& window, unsigned size) {
+  window.resize(size);
+  for (unsigned i = 0; i < size; ++i)
+    window[i] = 0.54 - 0.46 * cos(2 * M_PI * i / size);
+}
+
+void blackman(Array& window, unsigned size) {
+  window.resize(size);
+  for (unsigned i = 0; i < size; ++i)
+    window[i] = 0.42 - 0.5 * cos(2 * M_PI * i / size) +
+                0.08 * cos(4 * M_PI * i / size);
+}
+
+void blackman(std::vector<float>& window, unsigned size) {
+  window.resize(size);
+  for (unsigned i = 0; i < size; ++i)
+    window[i] = 0.42 - 0.5 * cos(2 * M_PI * i / size) +
+                0.08 * cos(4 * M_PI * i / size);
+}
+
 void normalize(float* data, unsigned size) {
   float max = 0;
   for (unsigned i = 0; i < size; ++i)
@@ -29,8 +78,10 @@ void normalize(float* data, unsigned size) {
   for (unsigned i = 0; i < size; ++i) data[i] /= max;
 }
 
+// a generator for each thread, rather than rand() and its lock
 float uniform(float low, float high) {
-  return low + (high - low) * float(rand()) / RAND_MAX;
+  static thread_local Random random(nextSeed());
+  return random.uniform(low, high);
 }
 float uniform(float high) { return uniform(0.0f, high); }
 float map(float value, float low, float high, float low_, float high_) {
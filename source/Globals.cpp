@@ -0,0 +1,9 @@
+#include "AudioPlatform/Globals.h"
+
+namespace ap {
+
+unsigned channelCount = 2;
+float sampleRate = 44100.0f;
+unsigned blockSize = 512;
+
+}  // namespace ap
@@ -1,11 +1,14 @@
-
 #include "AudioPlatform/MIDI.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <vector>
 
 namespace ap {
 
-void MIDI::setup() {
+void MIDI::setup(unsigned port, unsigned capacity) {
+  queue.setup(capacity);
+
   try {
     midiin = new RtMidiIn();
   } catch (RtMidiError &error) {
@@ -26,26 +29,71 @@ void MIDI::setup() {
     std::cout << "  Input Port #" << i + 1 << ": " << portName << '\n';
   }
 
+  // set the callback before opening the port so no message is missed
+  midiin->setCallback(&MIDI::callback, this);
+
   try {
-    unsigned int port = 0;
-    std::cout << "Attempting to open port 0 (first midi port)" << std::endl;
+    std::cout << "Attempting to open port " << port << std::endl;
     midiin->openPort(port);
   } catch (RtMidiError &error) {
     error.printMessage();
     // exit(1);
   }
 
-  // Don't ignore sysex, timing, or active sensing messages.
+  // ignore sysex, which does not fit in an Event, but not timing or active
+  // sensing messages.
   //
-  midiin->ignoreTypes(false, false, false);
+  midiin->ignoreTypes(true, false, false);
+}
+
+double MIDI::now() {
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+void MIDI::callback(double delta, std::vector<unsigned char> *message,
+                    void *user) {
+  MIDI &midi = *static_cast<MIDI *>(user);
+  Event event;
+  event.time = now();
+  if (message->size() > sizeof(event.data)) return;
+  event.size = message->size();
+  for (unsigned i = 0; i < event.size; ++i) event.data[i] = (*message)[i];
+
+  // if the audio thread has fallen this far behind, drop the message
+  midi.queue.push(event);
+}
+
+void MIDI::block(unsigned frames) {
+  // this block plays the events that arrived during the previous one
+  const double t = now();
+  begin = (end > 0) ? end : t;
+  end = t;
+  this->frames = frames;
+}
+
+bool MIDI::next(Event &event) {
+  if (!queue.available()) return false;
+  if (queue.peek().time >= end) return false;
+  queue.pop(event);
+
+  // place the event in this block as far in as it was in the last one.
+  // callbacks don't come exactly a block apart, so map the span between
+  // them onto the block rather than counting seconds at sampleRate.
+  const double span = end - begin;
+  const double offset =
+      (span > 0) ? (event.time - begin) / span * frames : 0;
+  event.offset =
+      (offset < 0 || frames == 0) ? 0 : std::min(unsigned(offset), frames - 1);
+  return true;
 }
 
 void MIDI::receive(std::vector<unsigned char> &message) {
-  double stamp = midiin->getMessage(&message);
-  int nBytes = message.size();
-  for (int i = 0; i < nBytes; i++)
-    std::cout << "Byte " << i << " = " << (int)message[i] << ", ";
-  if (nBytes > 0) std::cout << "stamp = " << stamp << std::endl;
+  Event event;
+  if (queue.pop(event))
+    message.assign(event.data, event.data + event.size);
+  else
+    message.clear();
 }
 
 }  // namespace ap
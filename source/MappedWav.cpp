@@ -0,0 +1,114 @@
+#include "AudioPlatform/MappedWav.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+
+namespace ap {
+
+bool MappedWav::open(std::string filePath) {
+  close();
+
+  int file = ::open(filePath.c_str(), O_RDONLY);
+  if (file < 0) return false;
+  struct stat status;
+  if (fstat(file, &status) < 0 || status.st_size == 0) {
+    ::close(file);
+    return false;
+  }
+  mapSize = status.st_size;
+  void* m = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, file, 0);
+  ::close(file);  // the mapping keeps the file open
+  if (m == MAP_FAILED) {
+    mapSize = 0;
+    return false;
+  }
+  map = (const unsigned char*)m;
+
+  if (!drwav_init_memory(&wav, map, mapSize)) {
+    close();
+    return false;
+  }
+
+  // drwav_init leaves the memory stream on the first byte of sample data
+  samples = map + wav.memoryStream.currentReadPos;
+  channels = wav.channels;
+  sampleRate = wav.sampleRate;
+  frames = wav.totalSampleCount / channels;
+  if (samples + frames * channels * wav.bytesPerSample > map + mapSize &&
+      wav.translatedFormatTag != DR_WAVE_FORMAT_ADPCM &&
+      wav.translatedFormatTag != DR_WAVE_FORMAT_DVI_ADPCM)
+    frames = (map + mapSize - samples) / (channels * wav.bytesPerSample);
+  return true;
+}
+
+void MappedWav::close() {
+  if (map != nullptr) munmap((void*)map, mapSize);
+  map = samples = nullptr;
+  mapSize = 0;
+  frames = channels = 0;
+  wav = drwav{};
+}
+
+bool MappedWav::direct() const {
+  if (map == nullptr) return false;
+  return wav.translatedFormatTag == DR_WAVE_FORMAT_IEEE_FLOAT &&
+         wav.bytesPerSample == 4 && (uintptr_t(samples) & 3) == 0;
+}
+
+const float* MappedWav::view(unsigned long long frame, unsigned count) {
+  if (map == nullptr) return nullptr;
+  const size_t n = size_t(count) * channels;
+  const unsigned char* p = samples + frame * channels * wav.bytesPerSample;
+  if (direct()) return (const float*)p;
+
+  if (buffer.size() < n) buffer.resize(n);
+  float* out = &buffer[0];
+  switch (wav.translatedFormatTag) {
+    case DR_WAVE_FORMAT_PCM:
+      switch (wav.bytesPerSample) {
+        case 1:
+          drwav_u8_to_f32(out, p, n);
+          return out;
+        case 2:
+          drwav_s16_to_f32(out, (const drwav_int16*)p, n);
+          return out;
+        case 3:
+          drwav_s24_to_f32(out, p, n);
+          return out;
+        case 4:
+          drwav_s32_to_f32(out, (const drwav_int32*)p, n);
+          return out;
+      }
+      break;
+    case DR_WAVE_FORMAT_IEEE_FLOAT:
+      if (wav.bytesPerSample == 4) {
+        // misaligned; copy rather than hand out an unaligned float*
+        std::memcpy(out, p, n * sizeof(float));
+        return out;
+      }
+      if (wav.bytesPerSample == 8) {
+        drwav_f64_to_f32(out, (const double*)p, n);
+        return out;
+      }
+      break;
+    case DR_WAVE_FORMAT_ALAW:
+      drwav_alaw_to_f32(out, p, n);
+      return out;
+    case DR_WAVE_FORMAT_MULAW:
+      drwav_mulaw_to_f32(out, p, n);
+      return out;
+  }
+
+  // compressed (ADPCM); these can only be decoded in order, from the start
+  // of a block, so let dr_wav seek and decode
+  drwav_seek_to_sample(&wav, frame * channels);
+  drwav_uint64 read = drwav_read_f32(&wav, n, out);
+  for (size_t i = read; i < n; ++i) out[i] = 0;
+  return out;
+}
+
+}  // namespace ap
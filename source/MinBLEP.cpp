@@ -0,0 +1,107 @@
+#include "AudioPlatform/MinBLEP.h"
+#include <algorithm>
+#include <cmath>
+#include "AudioPlatform/FFT.h"
+#include "AudioPlatform/Functions.h"
+
+namespace ap {
+
+MinBLEP::MinBLEP() {
+  // a band-limited impulse, oversampled by phases: a windowed sinc. the
+  // cutoff is a little below Nyquist, so that most of the transition band
+  // is below it too
+  const double cutoff = 0.9;
+  const unsigned n = length * phases;
+  std::vector<float> window;
+  blackman(window, n);
+  const unsigned size = 8 * n;  // padded, so the cepstrum does not alias
+  std::vector<float> data(size, 0);
+  for (unsigned i = 0; i < n; ++i) {
+    const double t = cutoff * M_PI * (double(i) - n / 2) / phases;
+    data[i] = window[i] * (t == 0 ? 1 : sin(t) / t);
+  }
+
+  // real cepstrum: the inverse FFT of the log magnitude
+  FFT fft;
+  fft.setup(size);
+  fft.forward(&data[0]);
+  for (unsigned i = 0; i < fft.real.size(); ++i) {
+    const float m = std::sqrt(fft.real[i] * fft.real[i] +
+                              fft.imag[i] * fft.imag[i]);
+    fft.real[i] = std::log(std::max(m, 1e-9f));
+    fft.imag[i] = 0;
+  }
+  fft.reverse(&data[0]);
+
+  // fold the anti-causal half onto the causal half, then take the spectrum
+  // back with exp to get the minimum-phase impulse
+  for (unsigned i = 1; i < size / 2; ++i) {
+    data[i] *= 2;
+    data[size - i] = 0;
+  }
+  fft.forward(&data[0]);
+  for (unsigned i = 0; i < fft.real.size(); ++i) {
+    const float m = std::exp(fft.real[i]);
+    const float p = fft.imag[i];
+    fft.real[i] = m * std::cos(p);
+    fft.imag[i] = m * std::sin(p);
+  }
+  fft.reverse(&data[0]);
+
+  // integrate the first length samples into a step that ends at exactly 1,
+  // and that step into a ramp. step[k] and ramp[k] are at time k / phases.
+  std::vector<double> step(n + 1), ramp(n + 1);
+  double sum = 0;
+  for (unsigned k = 0; k < n; ++k) sum += data[k];
+  step[0] = 0;
+  for (unsigned k = 0; k < n; ++k) step[k + 1] = step[k] + data[k] / sum;
+  ramp[0] = 0;
+  for (unsigned k = 0; k < n; ++k)
+    ramp[k + 1] = ramp[k] + (step[k] + step[k + 1]) / 2 / phases;
+  delay = double(n) / phases - ramp[n];
+
+  stepResidual.resize((phases + 1) * length);
+  rampResidual.resize((phases + 1) * length);
+  for (unsigned p = 0; p <= phases; ++p)
+    for (unsigned j = 0; j < length; ++j) {
+      const unsigned k = j * phases + p;
+      const double t = double(k) / phases;
+      stepResidual[p * length + j] = step[k] - 1;
+      rampResidual[p * length + j] = ramp[k] - t + delay;
+    }
+}
+
+const MinBLEP& MinBLEP::table() {
+  static const MinBLEP m;
+  return m;
+}
+
+// which two rows, and how far between them, for a time in [0, 1]
+static inline void row(float time, unsigned& p, float& t) {
+  const float x = std::min(std::max(time, 0.0f), 1.0f) * MinBLEP::phases;
+  p = x;
+  if (p >= MinBLEP::phases) p = MinBLEP::phases - 1;
+  t = x - p;
+}
+
+void MinBLEP::step(float* out, float time, float height) const {
+  unsigned p;
+  float t;
+  row(time, p, t);
+  const float* a = &stepResidual[p * length];
+  const float* b = a + length;
+  for (unsigned j = 0; j < length; ++j)
+    out[j] += height * (a[j] + (b[j] - a[j]) * t);
+}
+
+void MinBLEP::ramp(float* out, float time, float slope) const {
+  unsigned p;
+  float t;
+  row(time, p, t);
+  const float* a = &rampResidual[p * length];
+  const float* b = a + length;
+  for (unsigned j = 0; j < length; ++j)
+    out[j] += slope * (a[j] + (b[j] - a[j]) * t);
+}
+
+}  // namespace ap
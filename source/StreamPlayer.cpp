@@ -0,0 +1,122 @@
+#include "AudioPlatform/StreamPlayer.h"
+#include <chrono>
+#include <cstdio>
+#include "AudioPlatform/Globals.h"
+
+namespace ap {
+
+void StreamPlayer::load(std::string filePath, unsigned channel,
+                        unsigned buffer, unsigned chunkSize) {
+  close();
+
+  wav = drwav_open_file(filePath.c_str());
+  if (wav == nullptr) die("failed to open %s", filePath.c_str());
+  if (channel >= wav->channels)
+    die("%s has no channel %u", filePath.c_str(), channel);
+
+  this->channel = channel;
+  channels = wav->channels;
+  frames = wav->totalSampleCount / channels;
+  playbackRate = wav->sampleRate;
+
+  ring.setup(buffer > 2 * chunkSize ? buffer : 2 * chunkSize);
+  chunk.resize(chunkSize * channels);
+  mono.resize(chunkSize);
+  finished.store(false);
+  seekRequest.store(-1);
+  boundary.store(0);
+  seen = 0;
+  underruns = 0;
+  x0 = x1 = 0;
+  position = 1;
+
+  // the first chunk, so there is something to play as soon as we return
+  fill();
+
+  running.store(true);
+  thread = std::thread([this]() {
+    while (running.load()) {
+      long long frame = seekRequest.exchange(-1);
+      if (frame >= 0) {
+        drwav_seek_to_sample(wav, frame * channels);
+        finished.store(false);
+        // everything written up to here is from before the seek
+        boundary.store(ring.written.load(), std::memory_order_release);
+      }
+      if (finished.load() || ring.space() < mono.size() || !fill())
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  });
+
+  printf("%s -> streaming %llu samples @ %f Hz\n", filePath.c_str(), frames,
+         playbackRate);
+}
+
+void StreamPlayer::close() {
+  if (running.exchange(false)) thread.join();
+  if (wav != nullptr) drwav_close(wav);
+  wav = nullptr;
+}
+
+// read one chunk into the ring buffer. returns false at the end of the file
+bool StreamPlayer::fill() {
+  drwav_uint64 read = drwav_read_f32(wav, chunk.size(), &chunk[0]);
+  const unsigned n = read / channels;
+  for (unsigned i = 0; i < n; ++i) mono[i] = chunk[i * channels + channel];
+  ring.write(&mono[0], n);
+
+  if (n < mono.size()) {
+    if (loop.load())
+      drwav_seek_to_sample(wav, 0);
+    else
+      finished.store(true);
+    return false;
+  }
+  return true;
+}
+
+// returns true if there has been a seek since the last call, even if
+// everything from before it was already played
+bool StreamPlayer::skipStale() {
+  const unsigned long b = boundary.load(std::memory_order_acquire);
+  if (b == seen) return false;
+  seen = b;
+  const unsigned long t = ring.taken.load(std::memory_order_relaxed);
+  if (long(b - t) > 0) ring.skip(b - t);
+  return true;
+}
+
+float StreamPlayer::next() {
+  float f;
+  if (ring.pop(f)) return f;
+  if (!finished.load()) underruns++;
+  return 0;
+}
+
+void StreamPlayer::process(float* out, unsigned n) {
+  skipStale();
+  unsigned got = ring.read(out, n);
+  if (got < n && !finished.load()) underruns += n - got;
+  for (unsigned i = got; i < n; ++i) out[i] = 0;
+}
+
+void StreamPlayer::process(float* out, const float* rate, unsigned n) {
+  // the samples being interpolated are from before the seek; start over,
+  // as load() does
+  if (skipStale()) {
+    x0 = x1 = 0;
+    position = 1;
+  }
+  const float scale = playbackRate / sampleRate;
+  for (unsigned i = 0; i < n; ++i) {
+    position += (rate[i] > 0 ? rate[i] : 0) * scale;
+    while (position >= 1) {
+      x0 = x1;
+      x1 = next();
+      position -= 1;
+    }
+    out[i] = x0 + (x1 - x0) * position;
+  }
+}
+
+}  // namespace ap
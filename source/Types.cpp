@@ -1,26 +1,81 @@
 #include "AudioPlatform/Types.h"
 
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "AudioPlatform/Wav.h"
 
 namespace ap {
 
-Array::~Array() {
-  if (data) delete[] data;
+// 64-byte aligned, zeroed storage, or nullptr
+static float* aligned(size_t n) {
+  if (n == 0) return nullptr;
+  void* p = nullptr;
+  if (posix_memalign(&p, 64, sizeof(float) * n) != 0) return nullptr;
+  memset(p, 0, sizeof(float) * n);
+  return (float*)p;
+}
+
+Array::Array(const Array& other) { *this = other; }
+
+Array::Array(Array&& other) noexcept { *this = std::move(other); }
+
+Array& Array::operator=(const Array& other) {
+  if (this == &other) return *this;
+  resize(other.size);
+  if (size) memcpy(data, other.data, sizeof(float) * size);
+  return *this;
+}
+
+Array& Array::operator=(Array&& other) noexcept {
+  if (this == &other) return *this;
+  release();
+  data = other.data;
+  size = other.size;
+  borrowed = other.borrowed;
+  other.data = nullptr;
+  other.size = 0;
+  other.borrowed = false;
+  return *this;
+}
+
+Array::~Array() { release(); }
+
+void Array::release() {
+  if (!borrowed) free(data);
+  data = nullptr;
+  size = 0;
+  borrowed = false;
 }
 
 float& Array::operator[](unsigned index) { return data[index]; }
 float Array::operator[](const float index) const { return get(index); }
 
 void Array::resize(unsigned n) {
+  release();  // or your have a memory leak
+  data = aligned(n);
+  size = data ? n : 0;
+}
+
+void Array::resize(unsigned n, Arena& arena) {
+  release();
+  data = arena.allocate(n);
+  if (data) {
+    size = n;
+    borrowed = true;
+  } else
+    resize(n);
+}
+
+void Array::borrow(float* data, unsigned n) {
+  release();
+  this->data = data;
   size = n;
-  if (data) delete[] data;  // or your have a memory leak
-  if (n == 0) {
-    data = nullptr;
-  } else {
-    data = new float[n];
-    for (unsigned i = 0; i < n; ++i) data[i] = 0.0f;
-  }
+  borrowed = true;
 }
+
 void Array::zeros(unsigned n) { resize(n); }
 
 float Array::get(const float index) const {
@@ -38,4 +93,67 @@ void Array::add(const float index, const float value) {
   data[i] += value * (1 - t);
   data[j] += value * t;
 }
+
+Arena::~Arena() { free(data); }
+
+void Arena::setup(size_t capacity) {
+  free(data);
+  data = aligned(capacity);
+  this->capacity = data ? capacity : 0;
+  used = 0;
+}
+
+float* Arena::allocate(size_t n) {
+  const size_t room = footprint(n);
+  if (n == 0 || used + room > capacity) return nullptr;
+  float* p = data + used;
+  memset(p, 0, sizeof(float) * room);
+  used += room;
+  return p;
+}
+
+SampleBuffer::~SampleBuffer() { free(data); }
+
+void SampleBuffer::resize(unsigned channels, unsigned frames) {
+  free(data);
+  data = nullptr;
+  this->channels = channels;
+  this->frames = frames;
+
+  // room for the guard sample, rounded up to a whole number of cache lines
+  stride = (frames + 1 + 15) & ~15u;
+  data = aligned(size_t(stride) * channels);
+}
+
+bool SampleBuffer::load(const char* filePath) {
+  drwav* wav = drwav_open_file(filePath);
+  if (wav == nullptr) return false;
+  resize(wav->channels, wav->totalSampleCount / wav->channels);
+  sampleRate = wav->sampleRate;
+
+  // decode a chunk at a time, straight into the channels
+  const unsigned chunkFrames = 4096;
+  std::vector<float> chunk(chunkFrames * channels);
+  for (unsigned f = 0; f < frames;) {
+    const unsigned n = drwav_read_f32(wav, chunk.size(), &chunk[0]) / channels;
+    if (n == 0) break;
+    for (unsigned c = 0; c < channels; ++c) {
+      float* out = (*this)[c] + f;
+      const float* in = &chunk[c];
+      for (unsigned i = 0; i < n && f + i < frames; ++i)
+        out[i] = in[i * channels];
+    }
+    f += n;
+    if (n < chunkFrames) break;
+  }
+  drwav_close(wav);
+
+  guard();
+  return true;
+}
+
+void SampleBuffer::guard() {
+  for (unsigned c = 0; c < channels; ++c) (*this)[c][frames] = (*this)[c][0];
+}
+
 }  // namespace ap
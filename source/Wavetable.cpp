@@ -0,0 +1,163 @@
+#include "AudioPlatform/Wavetable.h"
+#include <cmath>
+#include "AudioPlatform/FFT.h"
+#include "AudioPlatform/FastMath.h"
+
+namespace ap {
+
+void Mipmap::build(const std::vector<float>& real,
+                   const std::vector<float>& imag) {
+  FFT fft;
+  fft.setup(size);
+  for (unsigned k = 0; k < levels; ++k) {
+    // keep DC and the first harmonics >> k harmonics; zero the rest
+    const unsigned keep = harmonics >> k;
+    fft.rectangular();
+    for (unsigned i = 0; i < fft.real.size(); ++i) {
+      const bool pass = i <= keep && i < real.size();
+      fft.real[i] = pass ? real[i] : 0;
+      fft.imag[i] = pass ? imag[i] : 0;
+    }
+    level[k].resize(size + 2);
+    fft.reverse(&level[k][0]);
+    level[k][size] = level[k][0];
+    level[k][size + 1] = level[k][1];
+  }
+}
+
+void Mipmap::harmonic(const std::vector<float>& b,
+                      const std::vector<float>& a) {
+  // the FFT of a * cos is a * size / 2 in the real part; that of b * sin is
+  // -b * size / 2 in the imaginary part
+  std::vector<float> real(size / 2 + 1, 0), imag(size / 2 + 1, 0);
+  for (unsigned n = 0; n < b.size() && n + 1 <= harmonics; ++n)
+    imag[n + 1] = -b[n] * size / 2;
+  for (unsigned n = 0; n < a.size() && n + 1 <= harmonics; ++n)
+    real[n + 1] = a[n] * size / 2;
+  build(real, imag);
+}
+
+void Mipmap::wave(const float* data, unsigned n) {
+  std::vector<float> cycle(size);
+  for (unsigned i = 0; i < size; ++i) {
+    const float index = float(i) * n / size;
+    const unsigned j = index;
+    const float t = index - j;
+    cycle[i] = data[j] + (data[(j + 1) % n] - data[j]) * t;
+  }
+  FFT fft;
+  fft.setup(size);
+  fft.forward(&cycle[0]);
+  build(fft.real, fft.imag);
+}
+
+// the presets match the naive Saw, Square and Triangle in Synths.h, and Sine
+
+const Mipmap& Mipmap::saw() {
+  static const Mipmap m = []() {
+    Mipmap m;
+    std::vector<float> b(harmonics);
+    for (unsigned n = 1; n <= harmonics; ++n) b[n - 1] = -2 / (M_PI * n);
+    m.harmonic(b);
+    return m;
+  }();
+  return m;
+}
+
+const Mipmap& Mipmap::square() {
+  static const Mipmap m = []() {
+    Mipmap m;
+    std::vector<float> b(harmonics);
+    for (unsigned n = 1; n <= harmonics; n += 2) b[n - 1] = -4 / (M_PI * n);
+    m.harmonic(b);
+    return m;
+  }();
+  return m;
+}
+
+const Mipmap& Mipmap::triangle() {
+  static const Mipmap m = []() {
+    Mipmap m;
+    std::vector<float> b(harmonics);
+    for (unsigned n = 1; n <= harmonics; n += 2)
+      b[n - 1] = ((n / 2) % 2 ? 8 : -8) / (M_PI * M_PI * n * n);
+    m.harmonic(b);
+    return m;
+  }();
+  return m;
+}
+
+const Mipmap& Mipmap::sine() {
+  static const Mipmap m = []() {
+    Mipmap m;
+    m.harmonic(std::vector<float>(1, 1.0f));
+    return m;
+  }();
+  return m;
+}
+
+// which level to read at a frequency (the one with the most harmonics that
+// all stay below Nyquist), and how much of the level below to mix in
+static inline void choose(float hz, unsigned& k, float& fade) {
+  // level k is alias-free while p <= k
+  const float p =
+      fastLog2(std::fabs(hz) * (2.0f * Mipmap::harmonics) / sampleRate);
+  fade = 0;
+  if (!(p > 0)) {  // 0 Hz, or NaN
+    k = 0;
+    return;
+  }
+  if (p > Mipmap::levels - 1) {  // including inf
+    k = Mipmap::levels - 1;
+    return;
+  }
+  k = unsigned(std::ceil(p));
+  const float t = (p - (k - 1)) * 4.0f;  // over a quarter octave
+  if (t < 1.0f) fade = 1.0f - t;
+}
+
+void Wavetable::lookup(float* out, float hz, unsigned n) const {
+  unsigned k;
+  float fade;
+  choose(hz, k, fade);
+  const float* a = &mipmap->level[k][0];
+  const float size = Mipmap::size;
+  if (fade == 0) {
+    for (unsigned i = 0; i < n; ++i) {
+      const float index = out[i] * size;
+      const unsigned j = index;
+      const float t = index - j;
+      out[i] = a[j] + (a[j + 1] - a[j]) * t;
+    }
+    return;
+  }
+
+  const float* b = &mipmap->level[k - 1][0];
+  for (unsigned i = 0; i < n; ++i) {
+    const float index = out[i] * size;
+    const unsigned j = index;
+    const float t = index - j;
+    const float x = a[j] + (a[j + 1] - a[j]) * t;
+    const float y = b[j] + (b[j + 1] - b[j]) * t;
+    out[i] = x + (y - x) * fade;
+  }
+}
+
+void Wavetable::lookup(float* out, const float* hz, unsigned n) const {
+  const float size = Mipmap::size;
+  for (unsigned i = 0; i < n; ++i) {
+    unsigned k;
+    float fade;
+    choose(hz[i], k, fade);
+    const float* a = &mipmap->level[k][0];
+    const float* b = &mipmap->level[k > 0 ? k - 1 : 0][0];
+    const float index = out[i] * size;
+    const unsigned j = index;
+    const float t = index - j;
+    const float x = a[j] + (a[j + 1] - a[j]) * t;
+    const float y = b[j] + (b[j + 1] - b[j]) * t;
+    out[i] = x + (y - x) * fade;
+  }
+}
+
+}  // namespace ap
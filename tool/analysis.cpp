@@ -13,7 +13,8 @@ const unsigned hopFactor = 8;
 using namespace ap;
 using namespace std;
 
-void findPeak(vector<float>& signal, vector<unsigned>& peak) {
+template <typename T>
+void findPeak(const T& signal, vector<unsigned>& peak) {
   for (unsigned i = 1; i < signal.size() - 1; ++i)
     if (signal[i - 1] < signal[i])
       if (signal[i + 1] < signal[i]) peak.push_back(i);
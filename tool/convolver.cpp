@@ -1,30 +1,12 @@
 #include <cmath>
 #include <iostream>
 #include <vector>
+#include "AudioPlatform/Convolver.h"
 #include "AudioPlatform/Synths.h"
 
 using namespace std;
 using namespace ap;
 
-void convolve(const vector<float> &f, const vector<float> &g,
-              vector<float> &fg) {
-  fg.resize(f.size() + g.size() - 1, 0);
-
-  // convolution process
-  for (unsigned i = 0; i < fg.size(); i++) {
-    int i1 = i;
-    float tmp = 0.0;
-    for (unsigned j = 0; j < g.size(); j++) {
-      if (i1 >= 0 && i1 < (int)f.size())
-        // accumulate
-        tmp = tmp + (f[i1] * g[j]);
-      i1 = i1 - 1;
-      fg[i] = tmp;
-    }
-    cout << i << " done of " << fg.size() << " is " << fg[i] << endl;
-  }
-}
-
 void fill(float *data, unsigned size, vector<float> &out) {
   out.resize(size);
   for (unsigned i = 0; i < out.size(); ++i) out[i] = data[i];
@@ -49,7 +31,7 @@ int main(int argc, char *argv[]) {
   //
   //
   vector<float> c;
-  convolve(a, b, c);
+  Convolver::convolve(&a[0], a.size(), &b[0], b.size(), c);
   normalize(c);
   SamplePlayer out;
   out.resize(c.size());
@@ -0,0 +1,318 @@
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "AudioPlatform/FastMath.h"
+#include "AudioPlatform/Functions.h"
+
+using namespace ap;
+
+// measure the error of the approximations in FastMath.h (and the
+// conversions in Functions.h built on them) against double precision libm,
+// and check it against the bounds documented there. the array versions are
+// checked against the scalar ones, which they should match to within a few
+// ulp (exactly, unless the compiler fuses multiply-adds in the scalar code).
+// exits with 1 if anything is out of bounds.
+
+int failures = 0;
+
+// a few ulp, for differences between the array and scalar versions
+const double closely = 5e-7;
+
+void report(const char* name, double error, double bound) {
+  const bool ok = error < bound;
+  if (!ok) failures++;
+  printf("%-24s %.3g\t(bound %.3g)\t%s\n", name, error, bound,
+         ok ? "ok" : "FAIL");
+}
+
+// the largest error over n points spread across [low, high]; relative
+// error divides by the size of the exact value
+template <typename Fast, typename Exact>
+double error(Fast fast, Exact exact, double low, double high, bool relative,
+             unsigned n = 1000000) {
+  double worst = 0;
+  for (unsigned i = 0; i <= n; ++i) {
+    const float x = low + (high - low) * i / n;
+    const double e = exact(double(x));
+    double d = std::fabs(fast(x) - e);
+    if (relative) d /= std::fabs(e);
+    if (d > worst) worst = d;
+  }
+  return worst;
+}
+
+// the largest error of fastAtan2 against atan2 on a grid over all four
+// quadrants, including the axes and both signs of zero
+double atan2Error() {
+  const float edge[] = {0.0f, -0.0f, 1.0f, -1.0f};
+  double worst = 0;
+  for (float y : edge)
+    for (float x : edge)
+      worst = std::fmax(worst, std::fabs(fastAtan2(y, x) - std::atan2(y, x)));
+  for (int i = -500; i <= 500; ++i)
+    for (int j = -500; j <= 500; ++j) {
+      const float y = i * 0.37f, x = j * 0.41f;
+      worst = std::fmax(worst,
+                        std::fabs(fastAtan2(y, x) - std::atan2(double(y), x)));
+    }
+  return worst;
+}
+
+// the largest difference between an array function and its scalar function,
+// relative to the scalar value, or with relative off, to the larger of it
+// and 1
+template <typename Array, typename Scalar>
+double mismatch(Array array, Scalar scalar, double low, double high,
+                bool relative) {
+  std::vector<float> in(4099), out(in.size());
+  for (unsigned i = 0; i < in.size(); ++i)
+    in[i] = low + (high - low) * i / (in.size() - 1);
+  array(&in[0], &out[0], in.size());
+  double worst = 0;
+  for (unsigned i = 0; i < in.size(); ++i) {
+    const double s = scalar(in[i]);
+    const double size = std::fabs(s);
+    worst = std::fmax(worst, std::fabs(out[i] - s) /
+                                 (relative || size > 1 ? size : 1.0));
+  }
+  return worst;
+}
+
+// at zero, infinity, NaN, negatives and denormals the result should be
+// what libm gives in float: the same infinity, zero or NaN, and otherwise
+// within bound (relative to the larger of it and 1). the array version is
+// given all the inputs at once, so its SIMD path sees them too.
+template <typename Array, typename Scalar, typename Exact>
+void special(const char* name, Array array, Scalar scalar, Exact exact,
+             std::vector<float> in, double bound) {
+  std::vector<float> out(in.size());
+  array(&in[0], &out[0], in.size());
+  unsigned wrong = 0;
+  for (unsigned i = 0; i < in.size(); ++i) {
+    const float e = float(exact(double(in[i])));
+    for (const float f : {scalar(in[i]), out[i]}) {
+      bool ok;
+      if (std::isnan(e))
+        ok = std::isnan(f);
+      else if (std::isinf(e) || e == 0)
+        ok = f == e;
+      else
+        ok = std::fabs(f - e) <= bound * std::fmax(1, std::fabs(e));
+      if (!ok) {
+        if (wrong++ == 0) printf("%s(%g) = %g, not %g\n", name, in[i], f, e);
+      }
+    }
+  }
+  if (wrong) failures++;
+  printf("%-24s %u wrong\t\t\t%s\n", name, wrong, wrong ? "FAIL" : "ok");
+}
+
+void specials() {
+  const float inf = HUGE_VALF, nan = NAN, denormal = 1e-40f;
+  const std::vector<float> positive = {0.0f, -0.0f, -1.0f, -inf, inf, nan,
+                                       denormal, 1.4e-45f, 1.17e-38f, 1.0f};
+  const std::vector<float> any = {-1000.0f, -200.0f, -inf, inf, nan, 0.0f,
+                                  1000.0f, 200.0f};
+
+  special("fastLog2 special",
+          [](const float* i, float* o, unsigned n) { fastLog2(i, o, n); },
+          [](float x) { return fastLog2(x); },
+          [](double x) { return std::log2(x); }, positive, 1e-6);
+  special("fastExp2 special",
+          [](const float* i, float* o, unsigned n) { fastExp2(i, o, n); },
+          [](float x) { return fastExp2(x); },
+          [](double x) { return std::exp2(x); }, any, 1e-6);
+  special("atodb special",
+          [](const float* i, float* o, unsigned n) { atodb(i, o, n); },
+          [](float a) { return atodb(a); },
+          [](double a) { return 20 * std::log10(a); }, positive, 1e-5);
+  special("ftom special",
+          [](const float* i, float* o, unsigned n) { ftom(i, o, n); },
+          [](float f) { return ftom(f); },
+          [](double f) { return 69 + 12 * std::log2(f / 440); }, positive,
+          5e-5);
+  special("dbtoa special",
+          [](const float* i, float* o, unsigned n) { dbtoa(i, o, n); },
+          [](float db) { return dbtoa(db); },
+          [](double db) { return std::pow(10.0, db / 20); }, any, 1e-6);
+  special("mtof special",
+          [](const float* i, float* o, unsigned n) { mtof(i, o, n); },
+          [](float m) { return mtof(m); },
+          [](double m) { return 440 * std::pow(2.0, (m - 69) / 12); }, any,
+          1e-5);
+}
+
+// toPolar and toRectangular, against libm and against the scalar functions
+// they should agree with, on points in every quadrant (and the
+// signed zeros) with magnitudes from 1e-3 to 1e3
+void polar() {
+  std::vector<float> re, im;
+  const float edge[] = {0.0f, -0.0f, 1.0f, -1.0f};
+  for (float y : edge)
+    for (float x : edge) {
+      re.push_back(x);
+      im.push_back(y);
+    }
+  for (unsigned i = 0; i < 100003; ++i) {
+    const double m = std::pow(10.0, -3 + 6.0 * i / 100003);
+    const double t = -M_PI + 2 * M_PI * ((i * 7919) % 100003) / 100003;
+    re.push_back(m * std::cos(t));
+    im.push_back(m * std::sin(t));
+  }
+  const unsigned n = re.size();
+  std::vector<float> magnitude(n), phase(n), re2(n), im2(n);
+  toPolar(&re[0], &im[0], &magnitude[0], &phase[0], n);
+
+  double m = 0, p = 0, exact = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    const double x = re[i], y = im[i], r = std::sqrt(x * x + y * y);
+    if (r > 0) m = std::fmax(m, std::fabs(magnitude[i] - r) / r);
+    p = std::fmax(p, std::fabs(phase[i] - std::atan2(y, x)));
+    const double q = fastAtan2(im[i], re[i]);
+    exact = std::fmax(exact,
+                      std::fabs(phase[i] - q) / std::fmax(1, std::fabs(q)));
+  }
+  report("toPolar magnitude (rel)", m, 2.5e-7);
+  report("toPolar phase", p, 1.2e-5);
+  report("toPolar[] vs fastAtan2", exact, closely);
+
+  // phases over the range fastSinCos is good for
+  for (unsigned i = 0; i < n; ++i) phase[i] = -100 + 200.0 * i / n;
+  toRectangular(&magnitude[0], &phase[0], &re2[0], &im2[0], n);
+  double e = 0;
+  exact = 0;
+  for (unsigned i = 0; i < n; ++i) {
+    const double r = magnitude[i], t = phase[i];
+    e = std::fmax(e, std::fabs(re2[i] - r * std::cos(t)) / r);
+    e = std::fmax(e, std::fabs(im2[i] - r * std::sin(t)) / r);
+    float s, c;
+    fastSinCos(phase[i], s, c);
+    exact = std::fmax(exact, std::fabs(re2[i] - magnitude[i] * c) / r);
+    exact = std::fmax(exact, std::fabs(im2[i] - magnitude[i] * s) / r);
+  }
+  report("toRectangular (rel)", e, 2e-7);
+  report("toRectangular[] vs fastSinCos", exact, closely);
+}
+
+int main() {
+  const Precision precision[] = {COARSE, FINE};
+  const char* name[] = {"COARSE", "FINE"};
+  char label[64];
+
+  for (unsigned p = 0; p < 2; ++p) {
+    const Precision q = precision[p];
+
+    snprintf(label, sizeof(label), "fastExp2 %s", name[p]);
+    report(label,
+           error([q](float x) { return fastExp2(x, q); },
+                 [](double x) { return std::exp2(x); }, -126, 127, true),
+           p ? 2.5e-7 : 7.5e-5);
+
+    snprintf(label, sizeof(label), "fastLog2 %s", name[p]);
+    report(label,
+           error([q](float x) { return fastLog2(x, q); },
+                 [](double x) { return std::log2(x); }, 0.5, 2, false),
+           p ? 2e-7 : 6e-6);
+
+    snprintf(label, sizeof(label), "fastTanh %s", name[p]);
+    report(label,
+           error([q](float x) { return fastTanh(x, q); },
+                 [](double x) { return std::tanh(x); }, -20, 20, false),
+           p ? 2.5e-7 : 4e-5);
+
+    snprintf(label, sizeof(label), "fastSin %s", name[p]);
+    report(label,
+           error([q](float x) { return fastSin(x, q); },
+                 [](double x) { return std::sin(x); }, -100, 100, false),
+           p ? 1e-7 : 1.2e-5);
+
+    snprintf(label, sizeof(label), "fastSin %s to 2^15", name[p]);
+    report(label,
+           error([q](float x) { return fastSin(x, q); },
+                 [](double x) { return std::sin(x); }, -32768, 32768, false,
+                 10000000),
+           p ? 5e-7 : 1.2e-5);
+
+    snprintf(label, sizeof(label), "fastExp2[] %s", name[p]);
+    report(label,
+           mismatch([q](const float* i, float* o,
+                        unsigned n) { fastExp2(i, o, n, q); },
+                    [q](float x) { return fastExp2(x, q); }, -130, 130,
+                    true),
+           closely);
+
+    snprintf(label, sizeof(label), "fastLog2[] %s", name[p]);
+    report(label,
+           mismatch([q](const float* i, float* o,
+                        unsigned n) { fastLog2(i, o, n, q); },
+                    [q](float x) { return fastLog2(x, q); }, 1e-3, 1e4,
+                    false),
+           closely);
+
+    snprintf(label, sizeof(label), "fastTanh[] %s", name[p]);
+    report(label,
+           mismatch([q](const float* i, float* o,
+                        unsigned n) { fastTanh(i, o, n, q); },
+                    [q](float x) { return fastTanh(x, q); }, -20, 20,
+                    false),
+           closely);
+  }
+
+  report("fastSinCos cos",
+         error(
+             [](float x) {
+               float s, c;
+               fastSinCos(x, s, c);
+               return c;
+             },
+             [](double x) { return std::cos(x); }, -100, 100, false),
+         1e-7);
+  report("fastSinCos cos to 2^15",
+         error(
+             [](float x) {
+               float s, c;
+               fastSinCos(x, s, c);
+               return c;
+             },
+             [](double x) { return std::cos(x); }, -32768, 32768, false,
+             10000000),
+         5e-7);
+  report("fastAtan2", atan2Error(), 1.2e-5);
+  polar();
+  specials();
+
+  // the conversions, over their musical ranges
+  report("mtof (relative)",
+         error([](float m) { return mtof(m); },
+               [](double m) { return 440 * std::pow(2.0, (m - 69) / 12); },
+               -20, 140, true),
+         1e-6);
+  report("ftom",
+         error([](float f) { return ftom(f); },
+               [](double f) { return 69 + 12 * std::log2(f / 440); }, 10,
+               22050, false),
+         5e-5);
+  report("dbtoa (relative)",
+         error([](float db) { return dbtoa(db); },
+               [](double db) { return std::pow(10.0, db / 20); }, -120, 24,
+               true),
+         1e-6);
+  report("atodb",
+         error([](float a) { return atodb(a); },
+               [](double a) { return 20 * std::log10(a); }, 1e-6, 16, false),
+         1e-5);
+  report("mtof[]", mismatch(
+                       [](const float* i, float* o, unsigned n) {
+                         mtof(i, o, n);
+                       },
+                       [](float m) { return mtof(m); }, -20, 140, true),
+         closely);
+  report("atodb[]", mismatch(
+                        [](const float* i, float* o, unsigned n) {
+                          atodb(i, o, n);
+                        },
+                        [](float a) { return atodb(a); }, 1e-6, 16, false),
+         closely);
+
+  return failures ? 1 : 0;
+}